@@ -0,0 +1,99 @@
+// Single pass downsampler for the mip chain of a 128x128 cubemap, in the spirit of FidelityFX SPD.
+// One thread group builds mips 1-7 of one face: mips 1-3 in registers, the rest through groupshared reductions.
+
+cbuffer FaceData : register(b0)
+{
+	uint FaceOffset;
+	uint3 pad0;
+};
+
+Texture2DArray<float4> InputTexture : register(t0);  // mip 0 only
+
+RWTexture2DArray<float4> OutputMip1 : register(u0);
+RWTexture2DArray<float4> OutputMip2 : register(u1);
+RWTexture2DArray<float4> OutputMip3 : register(u2);
+RWTexture2DArray<float4> OutputMip4 : register(u3);
+RWTexture2DArray<float4> OutputMip5 : register(u4);
+RWTexture2DArray<float4> OutputMip6 : register(u5);
+RWTexture2DArray<float4> OutputMip7 : register(u6);
+
+SamplerState LinearSampler : register(s0);
+
+static const float FaceSize = 128.0;
+
+groupshared float4 SharedMip[16][16];
+
+void StoreSharedMip(uint mip, uint3 coord, float4 value)
+{
+	switch (mip) {
+	case 4:
+		OutputMip4[coord] = value;
+		break;
+	case 5:
+		OutputMip5[coord] = value;
+		break;
+	case 6:
+		OutputMip6[coord] = value;
+		break;
+	case 7:
+		OutputMip7[coord] = value;
+		break;
+	}
+}
+
+[numthreads(16, 16, 1)] void main(uint3 GroupThreadID
+								  : SV_GroupThreadID, uint3 GroupID
+								  : SV_GroupID) {
+	uint face = GroupID.z + FaceOffset;
+
+	// Mip 1, each thread owns a 4x4 block. Sampling the shared corner of 2x2 texels averages them.
+	float4 mip1[4][4];
+	[unroll] for (uint y1 = 0; y1 < 4; y1++)
+	{
+		[unroll] for (uint x1 = 0; x1 < 4; x1++)
+		{
+			uint2 coord = GroupThreadID.xy * 4 + uint2(x1, y1);
+			float2 uv = (coord * 2 + 1) / FaceSize;
+			mip1[y1][x1] = InputTexture.SampleLevel(LinearSampler, float3(uv, face), 0);
+			OutputMip1[uint3(coord, face)] = mip1[y1][x1];
+		}
+	}
+
+	// Mip 2
+	float4 mip2[2][2];
+	[unroll] for (uint y2 = 0; y2 < 2; y2++)
+	{
+		[unroll] for (uint x2 = 0; x2 < 2; x2++)
+		{
+			mip2[y2][x2] = 0.25 * (mip1[y2 * 2][x2 * 2] + mip1[y2 * 2][x2 * 2 + 1] + mip1[y2 * 2 + 1][x2 * 2] + mip1[y2 * 2 + 1][x2 * 2 + 1]);
+			OutputMip2[uint3(GroupThreadID.xy * 2 + uint2(x2, y2), face)] = mip2[y2][x2];
+		}
+	}
+
+	// Mip 3
+	float4 mip3 = 0.25 * (mip2[0][0] + mip2[0][1] + mip2[1][0] + mip2[1][1]);
+	OutputMip3[uint3(GroupThreadID.xy, face)] = mip3;
+
+	SharedMip[GroupThreadID.y][GroupThreadID.x] = mip3;
+	GroupMemoryBarrierWithGroupSync();
+
+	// Mips 4-7
+	uint size = 8;
+	[unroll] for (uint mip = 4; mip < 8; mip++)
+	{
+		float4 value = 0;
+		bool active = all(GroupThreadID.xy < size);
+		if (active) {
+			uint2 src = GroupThreadID.xy * 2;
+			value = 0.25 * (SharedMip[src.y][src.x] + SharedMip[src.y][src.x + 1] + SharedMip[src.y + 1][src.x] + SharedMip[src.y + 1][src.x + 1]);
+			StoreSharedMip(mip, uint3(GroupThreadID.xy, face), value);
+		}
+		GroupMemoryBarrierWithGroupSync();
+
+		if (active)
+			SharedMip[GroupThreadID.y][GroupThreadID.x] = value;
+		GroupMemoryBarrierWithGroupSync();
+
+		size /= 2;
+	}
+}
@@ -12,13 +12,23 @@ static const float Epsilon = 0.00001;
 static const uint NumSamples = 16;
 static const float InvNumSamples = 1.0 / float(NumSamples);
 
-cbuffer SpecularMapFilterSettings : register(b0)
+cbuffer FaceData : register(b0)
 {
-	float roughness;
+	uint FaceOffset;
+	uint3 pad0;
 };
 
+// Matches MIPLEVELS in DynamicCubemaps.cpp, every mip below the first is filtered in one dispatch
+static const uint MipLevels = 8;
+
 TextureCube inputTexture : register(t0);
-RWTexture2DArray<float4> outputTexture : register(u0);
+RWTexture2DArray<float4> outputMip1 : register(u0);
+RWTexture2DArray<float4> outputMip2 : register(u1);
+RWTexture2DArray<float4> outputMip3 : register(u2);
+RWTexture2DArray<float4> outputMip4 : register(u3);
+RWTexture2DArray<float4> outputMip5 : register(u4);
+RWTexture2DArray<float4> outputMip6 : register(u5);
+RWTexture2DArray<float4> outputMip7 : register(u6);
 
 SamplerState linear_wrap_sampler : register(s0);
 
@@ -69,12 +79,9 @@ float ndfGGX(float cosLh, float roughness)
 // Calculate normalized sampling direction vector based on current fragment coordinates.
 // This is essentially "inverse-sampling": we reconstruct what the sampling vector would be if we wanted it to "hit"
 // this particular fragment in a cubemap.
-float3 getSamplingVector(uint3 ThreadID)
+float3 getSamplingVector(uint3 ThreadID, float outputSize)
 {
-	float outputWidth, outputHeight, outputDepth;
-	outputTexture.GetDimensions(outputWidth, outputHeight, outputDepth);
-
-	float2 st = ThreadID.xy / float2(outputWidth, outputHeight);
+	float2 st = ThreadID.xy / outputSize;
 	float2 uv = 2.0 * float2(st.x, 1.0 - st.y) - 1.0;
 
 	// Select vector based on cubemap face index.
@@ -119,25 +126,69 @@ float3 tangentToWorld(const float3 v, const float3 N, const float3 S, const floa
 	return S * v.x + T * v.y + N * v.z;
 }
 
-[numthreads(8, 8, 1)] void main(uint3 ThreadID
-								: SV_DispatchThreadID) {
-	// Make sure we won't write past output when computing higher mipmap levels.
-	uint outputWidth, outputHeight, outputDepth;
-	outputTexture.GetDimensions(outputWidth, outputHeight, outputDepth);
-	if (ThreadID.x >= outputWidth || ThreadID.y >= outputHeight) {
-		return;
+void storeMip(uint level, uint3 coord, float4 value)
+{
+	switch (level) {
+	case 1:
+		outputMip1[coord] = value;
+		break;
+	case 2:
+		outputMip2[coord] = value;
+		break;
+	case 3:
+		outputMip3[coord] = value;
+		break;
+	case 4:
+		outputMip4[coord] = value;
+		break;
+	case 5:
+		outputMip5[coord] = value;
+		break;
+	case 6:
+		outputMip6[coord] = value;
+		break;
+	case 7:
+		outputMip7[coord] = value;
+		break;
 	}
+}
 
+[numthreads(8, 8, 1)] void main(uint3 GroupThreadID
+								: SV_GroupThreadID, uint3 GroupID
+								: SV_GroupID) {
 	// Get input cubemap dimensions at zero mipmap level.
 	float inputWidth, inputHeight, inputLevels;
 	inputTexture.GetDimensions(0, inputWidth, inputHeight, inputLevels);
 
+	// Find the mip level this group belongs to, groups are laid out level after level
+	uint groupIndex = GroupID.x;
+	uint level = 1;
+	uint outputSize = max(1, (uint)inputWidth / 2);
+	[loop] while (level < MipLevels - 1) {
+		uint groupsPerRow = (outputSize + 7) / 8;
+		if (groupIndex < groupsPerRow * groupsPerRow)
+			break;
+		groupIndex -= groupsPerRow * groupsPerRow;
+		outputSize = max(1, outputSize / 2);
+		level++;
+	}
+
+	uint groupsPerRow = (outputSize + 7) / 8;
+	uint3 ThreadID = uint3(uint2(groupIndex % groupsPerRow, groupIndex / groupsPerRow) * 8 + GroupThreadID.xy, GroupID.z + FaceOffset);
+
+	// Make sure we won't write past output when computing higher mipmap levels.
+	if (ThreadID.x >= outputSize || ThreadID.y >= outputSize) {
+		return;
+	}
+
+	float roughness = level / float(MipLevels - 1);
+
 	// Solid angle associated with a single cubemap texel at zero mipmap level.
 	// This will come in handy for importance sampling below.
 	float wt = 4.0 * Math::PI / (6 * inputWidth * inputHeight);
 
 	// Approximation: Assume zero viewing angle (isotropic reflections).
-	float3 N = getSamplingVector(ThreadID);
+	float3 N = getSamplingVector(ThreadID, outputSize);
 	float3 Lo = N;
 
 	float3 S, T;
@@ -178,5 +229,5 @@ float3 tangentToWorld(const float3 v, const float3 N, const float3 S, const floa
 	}
 	color /= weight;
 
-	outputTexture[ThreadID] = float4(Color::LinearToGamma(color), 1.0);
+	storeMip(level, ThreadID, float4(Color::LinearToGamma(color), 1.0));
 }
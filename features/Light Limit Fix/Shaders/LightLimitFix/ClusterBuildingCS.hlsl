@@ -5,6 +5,8 @@ cbuffer PerFrame : register(b0)
 	row_major float4x4 InvProjMatrix[2];
 	float LightsNear;
 	float LightsFar;
+	float ClusterFarCutoff;
+	uint ClusterLogSlices;
 }
 
 float3 GetPositionVS(float2 texcoord, float depth, int eyeIndex = 0)
@@ -61,8 +63,13 @@ float3 IntersectionZPlane(float3 B, float z_dist)
 	float3 minPointVS = min(GetPositionVS(texcoordMin, 1.0f, 0), GetPositionVS(texcoordMin, 1.0f, 1));
 #endif  // !VR
 
-	float clusterNear = LightsNear * pow(LightsFar / LightsNear, groupId.z / float(CLUSTER_BUILDING_DISPATCH_SIZE_Z));
-	float clusterFar = LightsNear * pow(LightsFar / LightsNear, (groupId.z + 1) / float(CLUSTER_BUILDING_DISPATCH_SIZE_Z));
+	// Logarithmic slices up to the cutoff, a single slice from the cutoff to the far plane
+	float clusterNear = ClusterFarCutoff;
+	float clusterFar = LightsFar;
+	if (groupId.z < ClusterLogSlices) {
+		clusterNear = LightsNear * pow(ClusterFarCutoff / LightsNear, groupId.z / float(ClusterLogSlices));
+		clusterFar = LightsNear * pow(ClusterFarCutoff / LightsNear, (groupId.z + 1) / float(ClusterLogSlices));
+	}
 
 	float3 minPointNear = IntersectionZPlane(minPointVS, clusterNear);
 	float3 minPointFar = IntersectionZPlane(minPointVS, clusterFar);
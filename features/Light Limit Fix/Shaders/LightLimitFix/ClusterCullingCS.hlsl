@@ -3,6 +3,8 @@
 cbuffer PerFrame : register(b0)
 {
 	uint LightCount;
+	uint DirtyLightCount;
+	uint LightIndexCapacity;
 }
 
 //references
@@ -10,10 +12,12 @@ cbuffer PerFrame : register(b0)
 
 StructuredBuffer<ClusterAABB> clusters : register(t0);
 StructuredBuffer<Light> lights : register(t1);
+StructuredBuffer<DirtyLight> dirtyLights : register(t2);
 
 RWStructuredBuffer<uint> lightIndexCounter : register(u0);
 RWStructuredBuffer<uint> lightIndexList : register(u1);
 RWStructuredBuffer<LightGrid> lightGrid : register(u2);
+RWStructuredBuffer<uint> statistics : register(u3);
 
 groupshared Light sharedLights[GROUP_SIZE];
 
@@ -36,6 +40,7 @@ bool LightIntersectsCluster(float3 position, float radius, ClusterAABB cluster)
 
 	uint visibleLightCount = 0;
 	uint visibleLightIndices[MAX_CLUSTER_LIGHTS];
+	bool overflow = false;
 
 	uint clusterIndex = dispatchThreadId.x +
 	                    dispatchThreadId.y * CLUSTER_BUILDING_DISPATCH_SIZE_X +
@@ -43,6 +48,22 @@ bool LightIntersectsCluster(float3 position, float radius, ClusterAABB cluster)
 
 	ClusterAABB cluster = clusters[clusterIndex];
 
+	// Incremental update, clusters not touched by a moved light keep their previous result
+	if (DirtyLightCount > 0) {
+		bool dirty = false;
+		for (uint i = 0; i < DirtyLightCount && !dirty; i++) {
+			DirtyLight dirtyLight = dirtyLights[i];
+			float radius = dirtyLight.positionVS[0].w * dirtyLight.positionVS[0].w;
+#if defined(VR)
+			dirty = LightIntersectsCluster(dirtyLight.positionVS[0].xyz, radius, cluster) || LightIntersectsCluster(dirtyLight.positionVS[1].xyz, radius, cluster);
+#else
+			dirty = LightIntersectsCluster(dirtyLight.positionVS[0].xyz, radius, cluster);
+#endif
+		}
+		if (!dirty)
+			return;
+	}
+
 	if (groupIndex < LightCount) {
 		uint lightIndex = groupIndex;
 		Light light = lights[lightIndex];
@@ -63,10 +84,12 @@ bool LightIntersectsCluster(float3 position, float radius, ClusterAABB cluster)
 		[branch] if (LightIntersectsCluster(light.positionVS[0], radius, cluster))
 		{
 #endif
+			if (visibleLightCount >= MAX_CLUSTER_LIGHTS) {
+				overflow = true;
+				break;
+			}
 			visibleLightIndices[visibleLightCount] = i;
 			visibleLightCount++;
-			if (visibleLightCount >= MAX_CLUSTER_LIGHTS)
-				break;
 		}
 	}
 
@@ -75,6 +98,24 @@ bool LightIntersectsCluster(float3 position, float radius, ClusterAABB cluster)
 	uint offset = 0;
 	InterlockedAdd(lightIndexCounter[0], visibleLightCount, offset);
 
+	// The list is sized from observed occupancy and incremental updates append without compacting, never write past its end
+	uint storedLightCount = min(visibleLightCount, LightIndexCapacity - min(offset, LightIndexCapacity));
+	if (storedLightCount < visibleLightCount)
+		InterlockedAdd(statistics[STATS_TRUNCATED_CLUSTERS], 1);
+
+	// Occupancy statistics are only meaningful when every cluster is culled
+	if (DirtyLightCount == 0) {
+		InterlockedMax(statistics[STATS_MAX_LIGHTS], visibleLightCount);
+		InterlockedAdd(statistics[STATS_TOTAL_LIGHTS], visibleLightCount);
+		if (overflow)
+			InterlockedAdd(statistics[STATS_OVERFLOW_CLUSTERS], 1);
+
+		uint bin = visibleLightCount > 0 ? firstbithigh(visibleLightCount) + 1 : 0;
+		InterlockedAdd(statistics[STATS_HISTOGRAM + min(bin, STATS_HISTOGRAM_BINS - 1)], 1);
+	}
+
+	visibleLightCount = storedLightCount;
+
 	for (uint i = 0; i < visibleLightCount; i++) {
 		lightIndexList[offset + i] = visibleLightIndices[i];
 	}
@@ -7,6 +7,15 @@
 #define GROUP_SIZE (NUMTHREAD_X * NUMTHREAD_Y * NUMTHREAD_Z)
 #define MAX_CLUSTER_LIGHTS 256
 
+// Layout of the statistics buffer read back by the CPU
+#define STATS_MAX_LIGHTS 0
+#define STATS_TOTAL_LIGHTS 1
+#define STATS_OVERFLOW_CLUSTERS 2
+#define STATS_TRUNCATED_CLUSTERS 3
+#define STATS_INDEX_COUNT 4
+#define STATS_HISTOGRAM 5
+#define STATS_HISTOGRAM_BINS 10
+
 namespace LightFlags
 {
 	static const uint PortalStrict = (1 << 0);
@@ -27,6 +36,11 @@ struct LightGrid
 	uint pad0[2];
 };
 
+struct DirtyLight
+{
+	float4 positionVS[2];  // w: radius
+};
+
 struct Light
 {
 	float3 color;
@@ -12,20 +12,29 @@ namespace LightLimitFix
 	};
 
 	StructuredBuffer<Light> lights : register(t35);
-	StructuredBuffer<uint> lightList : register(t36);       //MAX_CLUSTER_LIGHTS * 16^3
-	StructuredBuffer<LightGrid> lightGrid : register(t37);  //16^3
+	StructuredBuffer<uint> lightList : register(t36);       //sized from observed occupancy
+	StructuredBuffer<LightGrid> lightGrid : register(t37);  //cluster count
 
 	bool GetClusterIndex(in float2 uv, in float z, inout uint clusterIndex)
 	{
 		const uint3 clusterSize = SharedData::lightLimitFixSettings.ClusterSize.xyz;
+		const uint logSlices = SharedData::lightLimitFixSettings.ClusterSize.w;
+		const float farCutoff = SharedData::lightLimitFixSettings.ClusterFarCutoff;
+		// Slice with the depth range the clusters were built with
+		const float clusterNear = SharedData::lightLimitFixSettings.ClusterNear;
+		const float clusterFar = SharedData::lightLimitFixSettings.ClusterFar;
 
-		z = max(z, SharedData::CameraData.y);
+		z = max(z, clusterNear);
 
-		if (z > SharedData::CameraData.x)
+		if (z > clusterFar)
 			return false;
 
-		float clampedZ = clamp(z, SharedData::CameraData.y, SharedData::CameraData.x);
-		uint clusterZ = uint(max((log2(z) - log2(SharedData::CameraData.y)) * clusterSize.z / log2(SharedData::CameraData.x / SharedData::CameraData.y), 0.0));
+		// Everything beyond the cutoff falls into the last slice
+		uint clusterZ = logSlices;
+		if (z < farCutoff)
+			clusterZ = uint(max((log2(z) - log2(clusterNear)) * logSlices / log2(farCutoff / clusterNear), 0.0));
+		clusterZ = min(clusterZ, clusterSize.z - 1);
+
 		uint3 cluster = uint3(uint2(uv * clusterSize.xy), clusterZ);
 
 		clusterIndex = cluster.x + (clusterSize.x * cluster.y) + (clusterSize.x * clusterSize.y * cluster.z);
@@ -61,7 +61,13 @@ cbuffer SSGICB : register(b1)
 
 	float BlurRadius;
 	float DistanceNormalisation;
-	float2 pad;
+	float ResScale;
+	float RcpResScale;
+
+	float PrevResScale;
+	float RcpPrevResScale;
+	uint ResMip;
+	float pad;
 };
 
 SamplerState samplerPointClamp : register(s0);
@@ -91,6 +97,8 @@ float4 filterNaN(float4 v) { return float4(filterNaN(v.x), filterNaN(v.y), filte
 #	define OUT_FRAME_DIM (FrameDim * 0.5)
 #	define RCP_OUT_FRAME_DIM (RcpFrameDim * 2)
 #	define OUT_FRAME_SCALE (frameScale * 0.5)
+#	define PREV_OUT_FRAME_DIM OUT_FRAME_DIM
+#	define RCP_PREV_OUT_FRAME_DIM RCP_OUT_FRAME_DIM
 #elif defined(QUARTER_RES)
 #	define RES_MIP 2
 #	define READ_DEPTH(tex, px) tex.Load(int3(px, RES_MIP))
@@ -98,6 +106,18 @@ float4 filterNaN(float4 v) { return float4(filterNaN(v.x), filterNaN(v.y), filte
 #	define OUT_FRAME_DIM (FrameDim * 0.25)
 #	define RCP_OUT_FRAME_DIM (RcpFrameDim * 4)
 #	define OUT_FRAME_SCALE (frameScale * 0.25)
+#	define PREV_OUT_FRAME_DIM OUT_FRAME_DIM
+#	define RCP_PREV_OUT_FRAME_DIM RCP_OUT_FRAME_DIM
+#elif defined(ADAPTIVE_RES)
+// arbitrary scale chosen per frame, the history may still be at last frame's scale
+#	define RES_MIP ResMip
+#	define READ_DEPTH(tex, px) tex.SampleLevel(samplerPointClamp, ((px) + .5) * RCP_OUT_FRAME_DIM * FrameDim * RcpTexDim, ResMip)
+#	define FULLRES_LOAD(tex, px, texCoord, samp) tex.SampleLevel(samp, texCoord, 0)
+#	define OUT_FRAME_DIM (FrameDim * ResScale)
+#	define RCP_OUT_FRAME_DIM (RcpFrameDim * RcpResScale)
+#	define OUT_FRAME_SCALE (frameScale * ResScale)
+#	define PREV_OUT_FRAME_DIM (FrameDim * PrevResScale)
+#	define RCP_PREV_OUT_FRAME_DIM (RcpFrameDim * RcpPrevResScale)
 #else
 #	define RES_MIP 0
 #	define READ_DEPTH(tex, px) tex[px]
@@ -105,8 +125,35 @@ float4 filterNaN(float4 v) { return float4(filterNaN(v.x), filterNaN(v.y), filte
 #	define OUT_FRAME_DIM FrameDim
 #	define RCP_OUT_FRAME_DIM RcpFrameDim
 #	define OUT_FRAME_SCALE frameScale
+#	define PREV_OUT_FRAME_DIM OUT_FRAME_DIM
+#	define RCP_PREV_OUT_FRAME_DIM RCP_OUT_FRAME_DIM
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+
+#if defined(TEMPORAL_DENOISER) && (defined(INTERLEAVE_HALF) || defined(INTERLEAVE_QUARTER) || (defined(VR) && defined(STEREO_SHARING)))
+#	define PARTIAL_TRACING
 #endif
 
+// Interleaved tracing, each frame only 1 of every 2 or 4 pixels is traced in a rotating pattern.
+// With stereo sharing the secondary eye additionally traces every other row, the rest is filled from the primary eye.
+// Untraced pixels keep their reprojected history unless it was disoccluded.
+bool IsTracePixel(uint2 pxCoord, uint eyeIndex)
+{
+	bool trace = true;
+#if defined(INTERLEAVE_HALF)
+	trace = ((pxCoord.x + pxCoord.y + FrameIndex) & 1) == 0;
+#elif defined(INTERLEAVE_QUARTER)
+	static const uint order[4] = { 0, 3, 1, 2 };
+	trace = ((pxCoord.x & 1) | ((pxCoord.y & 1) << 1)) == order[FrameIndex & 3];
+#endif
+#if defined(VR) && defined(STEREO_SHARING)
+	if (eyeIndex == 1)
+		trace = trace && ((pxCoord.y + (FrameIndex >> 2)) & 1) == 0;
+#endif
+	return trace;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 // Inputs are screen XY and viewspace depth, output is viewspace position
@@ -188,6 +188,8 @@ void CalculateGI(
 				mipLevel = max(mipLevel, 1);
 #elif defined(QUARTER_RES)
 				mipLevel = max(mipLevel, 2);
+#elif defined(ADAPTIVE_RES)
+				mipLevel = max(mipLevel, ResMip);
 #endif
 
 				float SZ = srcWorkingDepth.SampleLevel(samplerPointClamp, sampleUV * frameScale, mipLevel);
@@ -314,6 +316,33 @@ void CalculateGI(
 	o_currGIAOSpecular = float4(radianceSpecular, visibilitySpecular);
 }
 
+#if defined(VR) && defined(STEREO_SHARING)
+// Finds the same surface in the primary eye, whose history fills secondary eye pixels that were not traced.
+// IL is stored as world space SH, so it carries over between eyes.
+bool GetPrimaryEyeHistoryCoord(float2 uv, float viewspaceZ, out uint2 o_pxCoord)
+{
+	o_pxCoord = 0;
+
+	float2 screenPos = Stereo::ConvertFromStereoUV(uv, 1);
+	float3 worldPos = ViewToWorldPosition(ScreenToViewPosition(screenPos, viewspaceZ, 1), FrameBuffer::CameraViewInverse[1]);
+	worldPos += FrameBuffer::CameraPosAdjust[1].xyz - FrameBuffer::CameraPosAdjust[0].xyz;
+
+	float4 clipPos = mul(FrameBuffer::CameraViewProj[0], float4(worldPos, 1));
+	float2 primaryScreenPos = clipPos.xy / clipPos.w * float2(.5, -.5) + .5;
+	if (any(primaryScreenPos < 0) || any(primaryScreenPos > 1))
+		return false;
+
+	o_pxCoord = Stereo::ConvertToStereoUV(primaryScreenPos, 0) * OUT_FRAME_DIM;
+
+	// occluded in the primary eye
+	float primaryZ = READ_DEPTH(srcWorkingDepth, o_pxCoord);
+	if (abs(primaryZ - clipPos.w) > clipPos.w * DepthDisocclusion)
+		return false;
+
+	return srcAccumFrames[o_pxCoord] * 255 > 1.5;
+}
+#endif
+
 [numthreads(8, 8, 1)] void main(const uint2 dtid
 								: SV_DispatchThreadID) {
 	const float2 frameScale = FrameDim * RcpTexDim;
@@ -340,6 +369,26 @@ void CalculateGI(
 	float4 currGIAOSpecular = float4(0, 0, 0, 0);
 
 	bool needGI = viewspaceZ > FP_Z && viewspaceZ < DepthFadeRange.y;
+#ifdef PARTIAL_TRACING
+	if (needGI && !IsTracePixel(pxCoord, eyeIndex)) {
+		// a single accumulated frame means the history was just disoccluded, trace it regardless of the pattern
+		uint2 historyCoord = pxCoord;
+		bool reuseHistory = srcAccumFrames[pxCoord] * 255 > 1.5;
+#	if defined(VR) && defined(STEREO_SHARING)
+		if (!reuseHistory && eyeIndex == 1)
+			reuseHistory = GetPrimaryEyeHistoryCoord(uv, viewspaceZ, historyCoord);
+#	endif
+		if (reuseHistory) {
+			currAo = srcPrevAo[historyCoord];
+			currY = srcPrevY[historyCoord];
+			currCoCg = srcPrevCoCg[historyCoord];
+#	ifdef GI_SPECULAR
+			currGIAOSpecular = srcPrevGISpecular[historyCoord];
+#	endif
+			needGI = false;
+		}
+	}
+#endif
 	if (needGI) {
 		CalculateGI(
 			pxCoord, uv, viewspaceZ, viewspaceNormal,
@@ -31,7 +31,7 @@ void readHistory(
 	uint eyeIndex, float curr_depth, float3 curr_pos, int2 pixCoord, float bilinear_weight,
 	inout half prev_ao, inout half4 prev_y, inout half2 prev_co_cg, inout half3 prev_ambient, inout float accum_frames, inout half4 prev_gi_specular, inout float wsum)
 {
-	const float2 uv = (pixCoord + .5) * RCP_OUT_FRAME_DIM;
+	const float2 uv = (pixCoord + .5) * RCP_PREV_OUT_FRAME_DIM;
 	const float2 screen_pos = Stereo::ConvertFromStereoUV(uv, eyeIndex);
 	if (any(screen_pos < 0) || any(screen_pos > 1))
 		return;
@@ -105,7 +105,7 @@ void readHistory(
 		float3 curr_pos = ScreenToViewPosition(screen_pos, curr_depth, eyeIndex);
 		curr_pos = ViewToWorldPosition(curr_pos, FrameBuffer::CameraViewInverse[eyeIndex]) + FrameBuffer::CameraPosAdjust[eyeIndex].xyz;
 
-		float2 prev_px_coord = prev_uv * OUT_FRAME_DIM;
+		float2 prev_px_coord = prev_uv * PREV_OUT_FRAME_DIM;
 		int2 prev_px_lu = floor(prev_px_coord - 0.5);
 		float2 bilinear_weights = prev_px_coord - 0.5 - prev_px_lu;
 
@@ -150,7 +150,9 @@ void readHistory(
 #endif
 
 #ifdef TEMPORAL_DENOISER
-	accum_frames = max(1, min(accum_frames * 255 + 1, MaxAccumFrames));
+	// pixels skipped by interleaved tracing don't gain a sample, disoccluded ones are always traced
+	bool traced = IsTracePixel(pixCoord, eyeIndex) || accum_frames * 255 < 0.5;
+	accum_frames = max(1, min(accum_frames * 255 + traced, MaxAccumFrames));
 	outAccumFrames[pixCoord] = accum_frames / 255.0;
 	outRemappedAo[pixCoord] = prev_ao;
 	outRemappedIlY[pixCoord] = prev_y;
@@ -21,7 +21,9 @@ RWTexture2D<half4> outGiSpecular : register(u3);
 
 [numthreads(8, 8, 1)] void main(const uint2 dtid
 								: SV_DispatchThreadID) {
-#ifdef HALF_RES
+#ifdef ADAPTIVE_RES
+	int2 px00 = floor((dtid + .5) * ResScale - .5);
+#elif defined(HALF_RES)
 	int2 px00 = (dtid >> 1) + (dtid & 1) - 1;
 #else  // QUARTER_RES
 	int2 px00 = (dtid >> 2) + (dtid & 2) / 2 - 1;
@@ -30,11 +32,21 @@ RWTexture2D<half4> outGiSpecular : register(u3);
 	int2 px01 = px00 + int2(0, 1);
 	int2 px11 = px00 + int2(1, 1);
 
+#ifdef VR
+	// keep the footprint inside the current eye
+	const int eyeWidth = OUT_FRAME_DIM.x * 0.5;
+	const int2 eyeRange = (dtid.x + .5) * RcpFrameDim.x >= 0.5 ? int2(eyeWidth, 2 * eyeWidth - 1) : int2(0, eyeWidth - 1);
+	px00.x = clamp(px00.x, eyeRange.x, eyeRange.y);
+	px01.x = clamp(px01.x, eyeRange.x, eyeRange.y);
+	px10.x = clamp(px10.x, eyeRange.x, eyeRange.y);
+	px11.x = clamp(px11.x, eyeRange.x, eyeRange.y);
+#endif
+
 	float4 d = float4(
-		srcDepth.Load(int3(px00, RES_MIP)),
-		srcDepth.Load(int3(px01, RES_MIP)),
-		srcDepth.Load(int3(px10, RES_MIP)),
-		srcDepth.Load(int3(px11, RES_MIP)));
+		READ_DEPTH(srcDepth, px00),
+		READ_DEPTH(srcDepth, px01),
+		READ_DEPTH(srcDepth, px10),
+		READ_DEPTH(srcDepth, px11));
 
 	// note: edge-detection
 	float mind = min4(d);
@@ -6,7 +6,7 @@
 namespace Skylighting
 {
 #ifdef PSHADER
-	Texture3D<sh2> SkylightingProbeArray : register(t50);
+	Texture3D<uint2> SkylightingProbeArray : register(t50);
 	Texture2DArray<float3> stbn_vec3_2Dx1D_128x128x64 : register(t51);
 #endif
 
@@ -14,6 +14,39 @@ namespace Skylighting
 	const static float3 ARRAY_SIZE = 4096.f * 2.5f * float3(1, 1, 0.5);
 	const static float3 CELL_SIZE = ARRAY_SIZE / ARRAY_DIM;
 
+	// Probes are packed into one R32G32_UINT texel, so a trilinear sample is eight fetches.
+	// Each channel holds two 14-bit fixed point coefficients and 4 bits of an 8-bit accumulation counter.
+	// Typed UAV loads of R32G32 are optional, the update reads the array through an SRV and writes a separate texture, see UpdateProbesCS.hlsl.
+	// Coefficients are stored relative to a unit SH, so a cleared texel is a fully visible probe with no accumulated frames.
+	// Keep in sync with the encoding checks in Skylighting.cpp.
+	const static float PROBE_L0_RANGE = sqrt(4 * Math::PI);
+	const static float PROBE_L1_RANGE = sqrt(3) * PROBE_L0_RANGE;  // |L1| <= sqrt(3) * L0 for non-negative functions
+	const static float4 PROBE_RANGE = float4(PROBE_L0_RANGE, PROBE_L1_RANGE, PROBE_L1_RANGE, PROBE_L1_RANGE);
+	const static float PROBE_COEFF_SCALE = 8191.0;  // [-1, 1] to [0, 16382], zero is exact
+	const static uint PROBE_MAX_ACCUM_FRAMES = 255;
+
+	uint2 packProbe(sh2 probe, uint accumFrames)
+	{
+		const static sh2 unitSH = float4(PROBE_L0_RANGE, 0, 0, 0);
+		uint4 coeffs = round(clamp((probe - unitSH) / PROBE_RANGE, -1, 1) * PROBE_COEFF_SCALE + PROBE_COEFF_SCALE);
+		accumFrames = min(accumFrames, PROBE_MAX_ACCUM_FRAMES);
+
+		return uint2(
+			coeffs.x | (coeffs.y << 14) | ((accumFrames & 0xF) << 28),
+			coeffs.z | (coeffs.w << 14) | ((accumFrames >> 4) << 28));
+	}
+
+	sh2 unpackProbe(uint2 packed)
+	{
+		uint4 coeffs = uint4(packed.x, packed.x >> 14, packed.y, packed.y >> 14) & 0x3FFF;
+		return float4(PROBE_L0_RANGE, 0, 0, 0) + (coeffs / PROBE_COEFF_SCALE - 1.0) * PROBE_RANGE;
+	}
+
+	uint unpackAccumFrames(uint2 packed)
+	{
+		return (packed.x >> 28) | ((packed.y >> 28) << 4);
+	}
+
 	float getFadeOutFactor(float3 positionMS)
 	{
 		float3 uvw = saturate(positionMS / ARRAY_SIZE + .5);
@@ -32,7 +65,7 @@ namespace Skylighting
 		return lerp(params.MinSpecularVisibility, 1.0, saturate(visibility));
 	}
 
-	sh2 sample(SharedData::SkylightingSettings params, Texture3D<sh2> probeArray, Texture2DArray<float3> blueNoise, float2 screenPosition, float3 positionMS, float3 normalWS)
+	sh2 sample(SharedData::SkylightingSettings params, Texture3D<uint2> probeArray, Texture2DArray<float3> blueNoise, float2 screenPosition, float3 positionMS, float3 normalWS)
 	{
 		const static sh2 unitSH = float4(sqrt(4 * Math::PI), 0, 0, 0);
 		sh2 scaledUnitSH = unitSH / 1e-10;
@@ -83,7 +116,7 @@ namespace Skylighting
 			float w = trilinearWeights.x * trilinearWeights.y * trilinearWeights.z * tangentWeight;
 
 			uint3 cellTexID = (cellID + params.ArrayOrigin.xyz) % ARRAY_DIM;
-			sh2 probe = SphericalHarmonics::Scale(probeArray[cellTexID], w);
+			sh2 probe = SphericalHarmonics::Scale(unpackProbe(probeArray[cellTexID]), w);
 
 			sum = SphericalHarmonics::Add(sum, probe);
 			wsum += w;
@@ -92,7 +125,7 @@ namespace Skylighting
 		return SphericalHarmonics::Scale(sum, rcp(wsum + 1e-10));
 	}
 
-	sh2 sampleNoBias(SharedData::SkylightingSettings params, Texture3D<sh2> probeArray, float3 positionMS)
+	sh2 sampleNoBias(SharedData::SkylightingSettings params, Texture3D<uint2> probeArray, float3 positionMS)
 	{
 		const static sh2 unitSH = float4(sqrt(4 * Math::PI), 0, 0, 0);
 		sh2 scaledUnitSH = unitSH / 1e-10;
@@ -129,7 +162,7 @@ namespace Skylighting
 			float w = trilinearWeights.x * trilinearWeights.y * trilinearWeights.z;
 
 			uint3 cellTexID = (cellID + params.ArrayOrigin.xyz) % ARRAY_DIM;
-			sh2 probe = SphericalHarmonics::Scale(probeArray[cellTexID], w);
+			sh2 probe = SphericalHarmonics::Scale(unpackProbe(probeArray[cellTexID]), w);
 
 			sum = SphericalHarmonics::Add(sum, probe);
 			wsum += w;
@@ -2,21 +2,58 @@
 #include "Skylighting/Skylighting.hlsli"
 
 Texture2D<unorm float> srcOcclusionDepth : register(t0);
+Texture3D<uint2> srcProbeArray : register(t1);
 
-RWTexture3D<sh2> outProbeArray : register(u0);
-RWTexture3D<uint> outAccumFramesArray : register(u1);
+RWTexture3D<uint2> outProbeUpdate : register(u0);  // indexed by dispatch position, copied back into the probe array afterwards
 
 SamplerComparisonState comparisonSampler : register(s0);
 
-[numthreads(8, 8, 1)] void main(uint3 dtid
+cbuffer UpdateProbesCB : register(b0)
+{
+	uint3 DispatchOffset;
+	uint UpdateMode;
+	uint3 DispatchSize;
+	uint SampleWeight;  // occlusion samples each update stands for, refined probes are only updated every few samples
+};
+
+#define UPDATE_MODE_FULL 0
+#define UPDATE_MODE_SCROLLED 1  // DispatchOffset is in cell space
+#define UPDATE_MODE_REFINE 2    // DispatchOffset is in array space
+#define UPDATE_MODE_INVALIDATE 3  // DispatchOffset is in cell space
+
+[numthreads(8, 8, 1)] void main(uint3 dispatchID
 								: SV_DispatchThreadID) {
 	const float fadeInThreshold = 15;
 	const static sh2 unitSH = float4(sqrt(4.0 * Math::PI), 0, 0, 0);
 	const SharedData::SkylightingSettings settings = SharedData::skylightingSettings;
 
+	if (any(dispatchID >= DispatchSize))
+		return;
+
+	uint3 dtid;
+	if (UpdateMode == UPDATE_MODE_SCROLLED || UpdateMode == UPDATE_MODE_INVALIDATE)
+		dtid = (DispatchOffset + dispatchID + settings.ArrayOrigin.xyz) % Skylighting::ARRAY_DIM;
+	else
+		dtid = DispatchOffset + dispatchID;
+
 	uint3 cellID = (int3(dtid) - settings.ArrayOrigin.xyz) % Skylighting::ARRAY_DIM;
 	bool isValid = all(cellID >= max(0, settings.ValidMargin.xyz)) && all(cellID <= Skylighting::ARRAY_DIM - 1 + min(0, settings.ValidMargin.xyz));  // check if the cell is newly added
 
+	// Every probe in the dispatch is copied back, the ones left alone keep their previous value
+	uint2 prevProbe = srcProbeArray[dtid];
+
+	// Newly added cells are handled by the scrolled pass
+	if (UpdateMode == UPDATE_MODE_REFINE && !isValid) {
+		outProbeUpdate[dispatchID] = prevProbe;
+		return;
+	}
+
+	// No new occlusion sample this frame, newly added cells start from scratch
+	if (UpdateMode == UPDATE_MODE_INVALIDATE) {
+		outProbeUpdate[dispatchID] = Skylighting::packProbe(unitSH, 0);
+		return;
+	}
+
 	float3 cellCentreMS = cellID + 0.5 - Skylighting::ARRAY_DIM / 2;
 	cellCentreMS = cellCentreMS / Skylighting::ARRAY_DIM * Skylighting::ARRAY_SIZE + settings.PosOffset.xyz;
 
@@ -25,24 +62,27 @@ SamplerComparisonState comparisonSampler : register(s0);
 	float2 occlusionUV = cellCentreOS.xy * 0.5 + 0.5;
 
 	if (all(occlusionUV > 0) && all(occlusionUV < 1)) {
-		uint accumFrames = isValid ? (outAccumFramesArray[dtid] + 1) : 1;
+		if (!isValid)
+			prevProbe = 0;
+		uint prevAccumFrames = Skylighting::unpackAccumFrames(prevProbe);
+		uint accumFrames = prevAccumFrames + SampleWeight;
 		float occlusionDepth = srcOcclusionDepth.SampleCmpLevelZero(comparisonSampler, occlusionUV, 0);
 		float visibility = srcOcclusionDepth.SampleCmpLevelZero(comparisonSampler, occlusionUV, cellCentreOS.z);
 
 		sh2 occlusionSH = SphericalHarmonics::Scale(SphericalHarmonics::Evaluate(settings.OcclusionDir.xyz), visibility * 4.0 * Math::PI);  // 4 pi from monte carlo
 		if (isValid) {
-			float lerpFactor = rcp(accumFrames);
+			float lerpFactor = SampleWeight / float(accumFrames);
 			sh2 prevProbeSH = unitSH;
-			if (accumFrames > 1)
-				prevProbeSH += (outProbeArray[dtid] - unitSH) * fadeInThreshold / min(fadeInThreshold, accumFrames - 1);  // inverse confidence
+			if (prevAccumFrames > 0)
+				prevProbeSH += (Skylighting::unpackProbe(prevProbe) - unitSH) * fadeInThreshold / min(fadeInThreshold, prevAccumFrames);  // inverse confidence
 			occlusionSH = lerp(prevProbeSH, occlusionSH, lerpFactor);
 		}
 		occlusionSH = lerp(unitSH, occlusionSH, min(fadeInThreshold, accumFrames) / fadeInThreshold);  // confidence fade in
 
-		outProbeArray[dtid] = occlusionSH;
-		outAccumFramesArray[dtid] = accumFrames;
+		outProbeUpdate[dispatchID] = Skylighting::packProbe(occlusionSH, accumFrames);
 	} else if (!isValid) {
-		outProbeArray[dtid] = unitSH;
-		outAccumFramesArray[dtid] = 0;
+		outProbeUpdate[dispatchID] = Skylighting::packProbe(unitSH, 0);
+	} else {
+		outProbeUpdate[dispatchID] = prevProbe;
 	}
 }
\ No newline at end of file
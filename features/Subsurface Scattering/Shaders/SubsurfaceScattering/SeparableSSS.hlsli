@@ -130,14 +130,15 @@ float4 SSSSBlurCS(
 	finalStep *= 1.0 / 3.0;  // Divide by 3 as the kernels range from -3 to 3.
 
 #if defined(VR)
-	finalStep.x *= 0.5;               // Halve horizontal screen resolution
-	uint eyeIndex = texcoord >= 0.5;  // 0 = left 1 = right
+	finalStep.x *= 0.5;                 // Halve horizontal screen resolution
+	uint eyeIndex = texcoord.x >= 0.5;  // 0 = left 1 = right
 	uint bufferDimHalfX = uint(SharedData::BufferDim.x * 0.5);
-	uint2 minCoord = uint2(eyeIndex ? bufferDimHalfX : 0, 0);
-	uint2 maxCoord = uint2(eyeIndex ? SharedData::BufferDim.x : bufferDimHalfX, SharedData::BufferDim.y);
+	// Inclusive bounds, samples must not bleed into the other eye
+	int2 minCoord = int2(eyeIndex ? bufferDimHalfX : 0, 0);
+	int2 maxCoord = int2(eyeIndex ? SharedData::BufferDim.x : bufferDimHalfX, SharedData::BufferDim.y) - 1;
 #else
-	uint2 minCoord = uint2(0, 0);
-	uint2 maxCoord = uint2(SharedData::BufferDim.x, SharedData::BufferDim.y);
+	int2 minCoord = int2(0, 0);
+	int2 maxCoord = int2(SharedData::BufferDim.x, SharedData::BufferDim.y) - 1;
 #endif
 
 	float jitter = Random::InterleavedGradientNoise(DTid.xy, SharedData::FrameCount) * Math::TAU;
@@ -151,7 +152,8 @@ float4 SSSSBlurCS(
 		// Apply randomized rotation
 		offset = mul(offset, rotationMatrix);
 
-		uint2 coords = DTid.xy + int2(offset + 0.5);
+		// Signed so samples left of the eye clamp to its edge instead of wrapping around
+		int2 coords = int2(DTid.xy) + int2(offset + 0.5);
 
 		// Clamp for dynamic resolution
 		coords = clamp(coords, minCoord, maxCoord);
@@ -4,6 +4,8 @@ Texture2D<float4> ColorTexture : register(t0);
 Texture2D<float4> DepthTexture : register(t1);
 Texture2D<float4> MaskTexture : register(t2);
 
+StructuredBuffer<uint> TileList : register(t3);  // tile count and packed tile coordinates from TileClassifyCS
+
 #define SSSS_N_SAMPLES 21
 
 cbuffer PerFrameSSS : register(b1)
@@ -15,13 +17,21 @@ cbuffer PerFrameSSS : register(b1)
 };
 
 #include "Common/Color.hlsli"
+#include "Common/IndirectTiles.hlsli"
 #include "Common/Random.hlsli"
 #include "Common/SharedData.hlsli"
 
 #include "SubsurfaceScattering/SeparableSSS.hlsli"
 
-[numthreads(8, 8, 1)] void main(uint3 DTid
-								: SV_DispatchThreadID) {
+[numthreads(8, 8, 1)] void main(uint3 Gid
+								: SV_GroupID, uint3 GTid
+								: SV_GroupThreadID) {
+	uint2 tile;
+	if (!IndirectTiles::GetTile(TileList, Gid.xy, tile))
+		return;
+
+	uint2 DTid = tile * 8 + GTid.xy;
+
 	float2 texCoord = (DTid.xy + 0.5) * SharedData::BufferDim.zw;
 
 #if defined(HORIZONTAL)
@@ -37,6 +47,10 @@ cbuffer PerFrameSSS : register(b1)
 	float sssAmount = MaskTexture[DTid.xy].x;
 	bool humanProfile = MaskTexture[DTid.xy].y == sssAmount;
 
+	// Other pixels keep their color, skip the write
+	if (sssAmount == 0)
+		return;
+
 	float4 color = SSSSBlurCS(DTid.xy, texCoord, float2(0.0, 1.0), sssAmount, humanProfile);
 	color.rgb = Color::LinearToGamma(color.rgb);
 	SSSRW[DTid.xy] = float4(color.rgb, 1.0);
@@ -0,0 +1,102 @@
+// Builds the list of 8x8 tiles the blurs run on and their indirect dispatch arguments, in three passes.
+// Default: marks every tile within the kernel radius of a tile with scattering pixels.
+//          The vertical blur samples these tiles from the horizontal blur output, so they have to be written too.
+//          Kernels wider than MAX_DILATION_TILES request the whole screen instead of scattering.
+// COMPACT: appends the marked tiles to the tile list, or every screen tile when the whole screen was requested.
+// ARGS:    converts the tile count into dispatch arguments.
+
+RWStructuredBuffer<uint> TileList : register(u0);  // tile count followed by packed tile coordinates
+RWBuffer<uint> TileArgs : register(u1);            // ThreadGroupCountX, ThreadGroupCountY, ThreadGroupCountZ, the first is the whole screen flag until ARGS
+RWTexture2D<uint> TileMask : register(u2);
+
+#include "Common/IndirectTiles.hlsli"
+#include "Common/SharedData.hlsli"
+
+#if defined(COMPACT)
+
+[numthreads(8, 8, 1)] void main(uint3 DTid
+								: SV_DispatchThreadID) {
+	uint2 screenTiles = (uint2(SharedData::BufferDim.xy) + 7) / 8;
+
+	// Out of bounds loads return 0
+	if (TileArgs[0] ? all(DTid.xy < screenTiles) : TileMask[DTid.xy]) {
+		uint tileIndex;
+		InterlockedAdd(TileList[0], 1, tileIndex);
+		TileList[1 + tileIndex] = IndirectTiles::PackTile(DTid.xy);
+	}
+}
+
+#elif defined(ARGS)
+
+[numthreads(1, 1, 1)] void main() {
+	uint3 args = IndirectTiles::GetDispatchArgs(TileList[0]);
+	TileArgs[0] = args.x;
+	TileArgs[1] = args.y;
+	TileArgs[2] = args.z;
+}
+
+#else
+
+Texture2D<float4> DepthTexture : register(t1);
+Texture2D<float4> MaskTexture : register(t2);
+
+#	define SSSS_N_SAMPLES 21
+
+cbuffer PerFrameSSS : register(b1)
+{
+	float4 Kernels[SSSS_N_SAMPLES + SSSS_N_SAMPLES];
+	float4 BaseProfile;
+	float4 HumanProfile;
+	float SSSS_FOVY;
+};
+
+// Surfaces right in front of the camera blur across most of the screen, scattering that far costs more than blurring every tile
+#	define MAX_DILATION_TILES 16
+
+groupshared uint g_radius;
+
+[numthreads(8, 8, 1)] void main(uint3 DTid
+								: SV_DispatchThreadID, uint3 Gid
+								: SV_GroupID, uint GIndex
+								: SV_GroupIndex) {
+	if (GIndex == 0)
+		g_radius = 0;
+	GroupMemoryBarrierWithGroupSync();
+
+	// Out of bounds loads return 0
+	float sssAmount = MaskTexture[DTid.xy].x;
+	if (sssAmount > 0) {
+		bool humanProfile = MaskTexture[DTid.xy].y == sssAmount;
+		float blurRadius = humanProfile ? HumanProfile.x : BaseProfile.x;
+
+		float depth = SharedData::GetScreenDepth(DepthTexture[DTid.xy].r);
+		float distanceToProjectionWindow = 1.0 / tan(0.5 * radians(SSSS_FOVY));
+
+		// Furthest sample offset of SSSSBlurCS, the kernels range from -3 to 3 and the step is divided by 3
+		float radius = distanceToProjectionWindow / depth * max(SharedData::BufferDim.x, SharedData::BufferDim.y) * sssAmount * blurRadius;
+		InterlockedMax(g_radius, uint(radius) + 1);
+	}
+	GroupMemoryBarrierWithGroupSync();
+
+	if (g_radius == 0)
+		return;
+
+	int radius = (g_radius + 7) / 8;
+	if (radius > MAX_DILATION_TILES) {
+		if (GIndex == 0)
+			TileArgs[0] = 1;
+		return;
+	}
+
+	uint2 tileDims;
+	TileMask.GetDimensions(tileDims.x, tileDims.y);
+
+	int2 minTile = max(int2(Gid.xy) - radius, 0);
+	int2 maxTile = min(int2(Gid.xy) + radius, int2(tileDims) - 1);
+	uint2 size = uint2(maxTile - minTile) + 1;
+
+	for (uint i = GIndex; i < size.x * size.y; i += 64)
+		TileMask[uint2(minTile) + uint2(i % size.x, i / size.x)] = 1;
+}
+
+#endif
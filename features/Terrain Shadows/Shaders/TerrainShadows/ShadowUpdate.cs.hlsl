@@ -81,10 +81,7 @@ groupshared float2 g_shadowHeight[NTHREADS];
 	float2 threadUV = rawThreadUV - floor(rawThreadUV);  // wraparound
 	float2 threadPxCoord = threadUV * dims;
 
-	float2 pastHeights;
 	if (isValid) {
-		pastHeights = RWTexShadowHeights[uint2(threadPxCoord)];
-
 		// bifilter
 		float2 heights = GetInterpolatedHeight(threadPxCoord, isVertical).xx;
 
@@ -115,6 +112,6 @@ groupshared float2 g_shadowHeight[NTHREADS];
 
 	// save
 	if (isValid) {
-		RWTexShadowHeights[uint2(threadPxCoord)] = lerp(pastHeights, g_shadowHeight[gtid], 0.5f);
+		RWTexShadowHeights[uint2(threadPxCoord)] = g_shadowHeight[gtid];
 	}
 }
\ No newline at end of file
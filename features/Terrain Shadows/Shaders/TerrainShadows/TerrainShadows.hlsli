@@ -1,6 +1,7 @@
 namespace TerrainShadows
 {
-	Texture2D<float2> ShadowHeightTexture : register(t60);
+	Texture2D<float2> ShadowHeightTexture : register(t60);      // older sun direction
+	Texture2D<float2> NextShadowHeightTexture : register(t61);  // newer sun direction
 
 	float2 GetTerrainShadowUV(float2 xy)
 	{
@@ -21,7 +22,8 @@ namespace TerrainShadows
 	{
 		if (SharedData::terraOccSettings.EnableTerrainShadow) {
 			float2 terraOccUV = GetTerrainShadowUV(worldPos.xy);
-			float2 shadowHeight = GetTerrainZ(ShadowHeightTexture.SampleLevel(samp, terraOccUV, 0));
+			float2 shadowHeight = lerp(ShadowHeightTexture.SampleLevel(samp, terraOccUV, 0), NextShadowHeightTexture.SampleLevel(samp, terraOccUV, 0), SharedData::terraOccSettings.ShadowBlend);
+			shadowHeight = GetTerrainZ(shadowHeight);
 			float shadowFraction = saturate((worldPos.z - shadowHeight.y) / (shadowHeight.x - shadowHeight.y));
 			return shadowFraction;
 		}
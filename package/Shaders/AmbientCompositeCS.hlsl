@@ -1,6 +1,7 @@
 #include "Common/Color.hlsli"
 #include "Common/FrameBuffer.hlsli"
 #include "Common/GBuffer.hlsli"
+#include "Common/IndirectTiles.hlsli"
 #include "Common/Math.hlsli"
 #include "Common/SharedData.hlsli"
 #include "Common/Spherical Harmonics/SphericalHarmonics.hlsli"
@@ -13,7 +14,7 @@ Texture2D<float> DepthTexture : register(t2);
 #if defined(SKYLIGHTING)
 #	include "Skylighting/Skylighting.hlsli"
 
-Texture3D<sh2> SkylightingProbeArray : register(t3);
+Texture3D<uint2> SkylightingProbeArray : register(t3);
 Texture2DArray<float3> stbn_vec3_2Dx1D_128x128x64 : register(t4);
 
 #endif
@@ -26,6 +27,8 @@ Texture2D<half4> SsgiYTexture : register(t7);
 Texture2D<half2> SsgiCoCgTexture : register(t8);
 #endif
 
+StructuredBuffer<uint> TileList : register(t9);  // tile count and packed tile coordinates from DeferredTileClassifyCS
+
 RWTexture2D<half3> MainRW : register(u0);
 #if defined(SSGI)
 RWTexture2D<half3> DiffuseAmbientRW : register(u1);
@@ -41,8 +44,23 @@ void SampleSSGI(uint2 pixCoord, float3 normalWS, out half ao, out half3 il)
 }
 #endif
 
-[numthreads(8, 8, 1)] void main(uint3 dispatchID
-								: SV_DispatchThreadID) {
+[numthreads(8, 8, 1)] void main(uint3 Gid
+								: SV_GroupID, uint3 GTid
+								: SV_GroupThreadID) {
+	uint2 tile;
+	if (!IndirectTiles::GetTile(TileList, Gid.xy, tile))
+		return;
+
+	uint2 dispatchID = tile * 8 + GTid.xy;
+
+#if defined(SKY)
+	// Without albedo there is no ambient to add, only clear the history
+#	if defined(SSGI)
+	DiffuseAmbientRW[dispatchID.xy] = 0;
+#	endif
+	return;
+#endif
+
 	half2 uv = half2(dispatchID.xy + 0.5) * SharedData::BufferDim.zw;
 	uint eyeIndex = Stereo::GetEyeIndexFromTexCoord(uv);
 	uv *= FrameBuffer::DynamicResolutionParams2.xy;  // adjust for dynamic res
@@ -0,0 +1,32 @@
+#ifndef __INDIRECT_TILES_DEPENDENCY_HLSL__
+#define __INDIRECT_TILES_DEPENDENCY_HLSL__
+
+// Lists of 8x8 screen tiles that are dispatched indirectly with one thread group per tile.
+// Element 0 of a list holds the tile count, the packed tile coordinates follow.
+// A dispatch is limited to 65535 groups per dimension, which a 1D dispatch exceeds at 4K and in VR, so the groups are spread over rows.
+namespace IndirectTiles
+{
+	static const uint DispatchWidth = 1024;
+
+	uint PackTile(uint2 tile)
+	{
+		return tile.x | (tile.y << 16);
+	}
+
+	// ThreadGroupCountX, ThreadGroupCountY, ThreadGroupCountZ
+	uint3 GetDispatchArgs(uint tileCount)
+	{
+		return uint3(min(tileCount, DispatchWidth), (tileCount + DispatchWidth - 1) / DispatchWidth, 1);
+	}
+
+	// Returns false for the unused groups of the last row
+	bool GetTile(StructuredBuffer<uint> tileList, uint2 groupId, out uint2 tile)
+	{
+		uint tileIndex = groupId.x + groupId.y * DispatchWidth;
+		uint packedTile = tileList[1 + tileIndex];
+		tile = uint2(packedTile & 0xFFFF, packedTile >> 16);
+		return tileIndex < tileList[0];
+	}
+}
+
+#endif  //__INDIRECT_TILES_DEPENDENCY_HLSL__
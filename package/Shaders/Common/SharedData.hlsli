@@ -60,6 +60,8 @@ namespace SharedData
 		float3 Scale;
 		float2 ZRange;
 		float2 Offset;
+		float ShadowBlend;
+		float3 pad0;
 	};
 
 	struct LightLimitFixSettings
@@ -67,8 +69,11 @@ namespace SharedData
 		uint EnableContactShadows;
 		uint EnableLightsVisualisation;
 		uint LightsVisualisationMode;
-		float LightsFar;
-		uint4 ClusterSize;
+		float ClusterFarCutoff;
+		uint4 ClusterSize;  // w: number of logarithmic Z slices
+		float ClusterNear;
+		float ClusterFar;
+		float2 pad0;
 	};
 
 	struct WetnessEffectsSettings
@@ -129,15 +134,16 @@ namespace SharedData
 		uint2 pad0;
 	};
 
+	// Offsets are checked against the C++ structs in FeatureBuffer.cpp, update both together
 	cbuffer FeatureData : register(b6)
 	{
-		GrassLightingSettings grassLightingSettings;
-		CPMSettings extendedMaterialSettings;
-		CubemapCreatorSettings cubemapCreatorSettings;
-		TerraOccSettings terraOccSettings;
-		LightLimitFixSettings lightLimitFixSettings;
-		WetnessEffectsSettings wetnessEffectsSettings;
-		SkylightingSettings skylightingSettings;
+		GrassLightingSettings grassLightingSettings : packoffset(c0);
+		CPMSettings extendedMaterialSettings : packoffset(c2);
+		CubemapCreatorSettings cubemapCreatorSettings : packoffset(c4);
+		TerraOccSettings terraOccSettings : packoffset(c6);
+		LightLimitFixSettings lightLimitFixSettings : packoffset(c9);
+		WetnessEffectsSettings wetnessEffectsSettings : packoffset(c12);
+		SkylightingSettings skylightingSettings : packoffset(c24);
 	};
 
 	Texture2D<float4> DepthTexture : register(t17);
@@ -2,6 +2,7 @@
 #include "Common/Color.hlsli"
 #include "Common/FrameBuffer.hlsli"
 #include "Common/GBuffer.hlsli"
+#include "Common/IndirectTiles.hlsli"
 #include "Common/MotionBlur.hlsli"
 #include "Common/SharedData.hlsli"
 #include "Common/Spherical Harmonics/SphericalHarmonics.hlsli"
@@ -29,7 +30,7 @@ SamplerState LinearSampler : register(s0);
 #if defined(SKYLIGHTING)
 #	include "Skylighting/Skylighting.hlsli"
 
-Texture3D<sh2> SkylightingProbeArray : register(t9);
+Texture3D<uint2> SkylightingProbeArray : register(t9);
 Texture2DArray<float3> stbn_vec3_2Dx1D_128x128x64 : register(t10);
 
 #endif
@@ -64,8 +65,17 @@ void SampleSSGISpecular(uint2 pixCoord, sh2 lobe, out half ao, out half3 il)
 }
 #endif
 
-[numthreads(8, 8, 1)] void main(uint3 dispatchID
-								: SV_DispatchThreadID) {
+StructuredBuffer<uint> TileList : register(t15);  // tile count and packed tile coordinates from DeferredTileClassifyCS
+
+[numthreads(8, 8, 1)] void main(uint3 Gid
+								: SV_GroupID, uint3 GTid
+								: SV_GroupThreadID) {
+	uint2 tile;
+	if (!IndirectTiles::GetTile(TileList, Gid.xy, tile))
+		return;
+
+	uint2 dispatchID = tile * 8 + GTid.xy;
+
 	half2 uv = half2(dispatchID.xy + 0.5) * SharedData::BufferDim.zw;
 	uint eyeIndex = Stereo::GetEyeIndexFromTexCoord(uv);
 	uv *= FrameBuffer::DynamicResolutionParams2.xy;  // Adjust for dynamic res
@@ -0,0 +1,71 @@
+// Sorts 8x8 tiles of the deferred composite into buckets, each dispatched indirectly with its own permutation.
+// Sky:    only sky pixels without albedo, the ambient composite leaves these unchanged
+// Simple: no reflective pixels, the main composite skips cubemaps, skylighting and specular GI
+// Full:   everything else
+// With ARGS defined, converts the tile counts into the dispatch arguments of the buckets instead.
+
+RWStructuredBuffer<uint> SkyTiles : register(u0);  // tile count followed by packed tile coordinates
+RWStructuredBuffer<uint> SimpleTiles : register(u1);
+RWStructuredBuffer<uint> FullTiles : register(u2);
+RWBuffer<uint> TileArgs : register(u3);  // ThreadGroupCountX, Y, Z for sky, simple and full
+
+#include "Common/IndirectTiles.hlsli"
+
+#if defined(ARGS)
+
+[numthreads(1, 1, 1)] void main() {
+	uint3 tileCounts = uint3(SkyTiles[0], SimpleTiles[0], FullTiles[0]);
+
+	[unroll] for (uint i = 0; i < 3; i++)
+	{
+		uint3 args = IndirectTiles::GetDispatchArgs(tileCounts[i]);
+		TileArgs[i * 3 + 0] = args.x;
+		TileArgs[i * 3 + 1] = args.y;
+		TileArgs[i * 3 + 2] = args.z;
+	}
+}
+
+#else
+
+Texture2D<float> DepthTexture : register(t0);
+Texture2D<unorm half3> AlbedoTexture : register(t1);
+Texture2D<unorm half3> ReflectanceTexture : register(t2);  // unbound without dynamic cubemaps
+
+groupshared uint g_notSky;
+groupshared uint g_reflective;
+
+[numthreads(8, 8, 1)] void main(uint3 DTid
+								: SV_DispatchThreadID, uint3 Gid
+								: SV_GroupID, uint GIndex
+								: SV_GroupIndex) {
+	if (GIndex == 0) {
+		g_notSky = 0;
+		g_reflective = 0;
+	}
+	GroupMemoryBarrierWithGroupSync();
+
+	if (DepthTexture[DTid.xy] < 1.0 || any(AlbedoTexture[DTid.xy] > 0.0))
+		InterlockedMax(g_notSky, 1);
+
+	if (any(ReflectanceTexture[DTid.xy] > 0.0))
+		InterlockedMax(g_reflective, 1);
+
+	GroupMemoryBarrierWithGroupSync();
+
+	if (GIndex == 0) {
+		uint packedTile = IndirectTiles::PackTile(Gid.xy);
+		uint tileIndex;
+		if (g_reflective) {
+			InterlockedAdd(FullTiles[0], 1, tileIndex);
+			FullTiles[1 + tileIndex] = packedTile;
+		} else if (g_notSky) {
+			InterlockedAdd(SimpleTiles[0], 1, tileIndex);
+			SimpleTiles[1 + tileIndex] = packedTile;
+		} else {
+			InterlockedAdd(SkyTiles[0], 1, tileIndex);
+			SkyTiles[1 + tileIndex] = packedTile;
+		}
+	}
+}
+
+#endif
@@ -2,6 +2,7 @@
 
 #include <DirectXMath.h>
 #include <d3d11.h>
+#include <d3d11_1.h>
 
 #include <Windows.Foundation.h>
 #include <stdio.h>
@@ -9,6 +10,8 @@
 #include <wrl\client.h>
 #include <wrl\wrappers\corewrappers.h>
 
+#include "Profiler.h"
+
 template <typename T>
 D3D11_BUFFER_DESC StructuredBufferDesc(uint64_t count, bool uav = true, bool dynamic = false)
 {
@@ -46,20 +49,149 @@ D3D11_BUFFER_DESC ConstantBufferDesc(bool dynamic = true)
 	return ConstantBufferDesc(sizeof(T), dynamic);
 }
 
+/**
+ * Upload ring for small, frequently updated constant buffers.
+ * Each update is sub-allocated from one large dynamic buffer with MAP_WRITE_NO_OVERWRITE and bound with
+ * the D3D11.1 *SetConstantBuffers1 offsets. The buffer is only discarded (renamed) when the ring wraps.
+ */
+class ConstantBufferRing
+{
+public:
+	static ConstantBufferRing* GetSingleton()
+	{
+		static ConstantBufferRing singleton;
+		return &singleton;
+	}
+
+	static constexpr UINT Size = 4 * 1024 * 1024;
+	static constexpr UINT Alignment = 256;  // *SetConstantBuffers1 offsets are in multiples of 16 constants
+
+	struct Allocation
+	{
+		ID3D11Buffer* buffer = nullptr;
+		UINT firstConstant = 0;
+		UINT numConstants = 0;
+	};
+
+	bool IsSupported()
+	{
+		if (!initialized)
+			Initialize();
+		return resource != nullptr;
+	}
+
+	Allocation Allocate(void const* src_data, size_t data_size)
+	{
+		UINT alignedSize = ((UINT)data_size + (Alignment - 1)) & ~(Alignment - 1);
+
+		D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+		if (offset + alignedSize > Size) {
+			offset = 0;
+			mapType = D3D11_MAP_WRITE_DISCARD;
+		}
+
+		D3D11_MAPPED_SUBRESOURCE mapped{};
+		DX::ThrowIfFailed(context->Map(resource.get(), 0u, mapType, 0u, &mapped));
+		memcpy((std::uint8_t*)mapped.pData + offset, src_data, data_size);
+		context->Unmap(resource.get(), 0);
+
+		Allocation allocation{ resource.get(), offset / 16, alignedSize / 16 };
+		offset += alignedSize;
+		return allocation;
+	}
+
+	void PSSet(UINT a_slot, Allocation const& a_allocation) const
+	{
+		context->PSSetConstantBuffers1(a_slot, 1, &a_allocation.buffer, &a_allocation.firstConstant, &a_allocation.numConstants);
+	}
+
+	void CSSet(UINT a_slot, Allocation const& a_allocation) const
+	{
+		context->CSSetConstantBuffers1(a_slot, 1, &a_allocation.buffer, &a_allocation.firstConstant, &a_allocation.numConstants);
+	}
+
+private:
+	void Initialize()
+	{
+		initialized = true;
+
+		auto renderer = RE::BSGraphics::Renderer::GetSingleton();
+		auto device = reinterpret_cast<ID3D11Device*>(renderer->GetRuntimeData().forwarder);
+		auto ctx = reinterpret_cast<ID3D11DeviceContext*>(renderer->GetRuntimeData().context);
+
+		D3D11_FEATURE_DATA_D3D11_OPTIONS options{};
+		if (FAILED(device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))) ||
+			!options.ConstantBufferOffsetting || !options.MapNoOverwriteOnDynamicConstantBuffer) {
+			logger::info("Constant buffer offsetting is not supported, using individual constant buffers");
+			return;
+		}
+
+		if (FAILED(ctx->QueryInterface(IID_PPV_ARGS(context.put()))))
+			return;
+
+		D3D11_BUFFER_DESC desc{};
+		desc.Usage = D3D11_USAGE_DYNAMIC;
+		desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+		desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		desc.ByteWidth = Size;
+		DX::ThrowIfFailed(device->CreateBuffer(&desc, nullptr, resource.put()));
+	}
+
+	winrt::com_ptr<ID3D11DeviceContext1> context;
+	winrt::com_ptr<ID3D11Buffer> resource;
+	UINT offset = Size;  // First allocation discards
+	bool initialized = false;
+};
+
 class ConstantBuffer
 {
 public:
-	explicit ConstantBuffer(D3D11_BUFFER_DESC const& a_desc) :
+	/**
+	 * \param a_suballocate Sub-allocate updates from the ConstantBufferRing when supported.
+	 * Such buffers must be bound with PSSet/CSSet after every Update, not through CB().
+	 */
+	explicit ConstantBuffer(D3D11_BUFFER_DESC const& a_desc, bool a_suballocate = false) :
 		desc(a_desc)
 	{
+		if (a_suballocate && (desc.Usage & D3D11_USAGE_DYNAMIC) && ConstantBufferRing::GetSingleton()->IsSupported()) {
+			suballocated = true;
+			return;
+		}
+
 		auto device = reinterpret_cast<ID3D11Device*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().forwarder);
 		DX::ThrowIfFailed(device->CreateBuffer(&desc, nullptr, resource.put()));
+		memory = TrackedMemory(desc.ByteWidth);
+	}
+
+	ID3D11Buffer* CB() const { return suballocated ? allocation.buffer : resource.get(); }
+
+	void PSSet(ID3D11DeviceContext* ctx, UINT a_slot) const
+	{
+		if (suballocated) {
+			ConstantBufferRing::GetSingleton()->PSSet(a_slot, allocation);
+		} else {
+			ID3D11Buffer* buffer = resource.get();
+			ctx->PSSetConstantBuffers(a_slot, 1, &buffer);
+		}
 	}
 
-	ID3D11Buffer* CB() const { return resource.get(); }
+	void CSSet(ID3D11DeviceContext* ctx, UINT a_slot) const
+	{
+		if (suballocated) {
+			ConstantBufferRing::GetSingleton()->CSSet(a_slot, allocation);
+		} else {
+			ID3D11Buffer* buffer = resource.get();
+			ctx->CSSetConstantBuffers(a_slot, 1, &buffer);
+		}
+	}
 
 	void Update(void const* src_data, size_t data_size)
 	{
+		if (suballocated) {
+			allocation = ConstantBufferRing::GetSingleton()->Allocate(src_data, data_size);
+			return;
+		}
+
 		ID3D11DeviceContext* ctx = reinterpret_cast<ID3D11DeviceContext*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().context);
 		if (desc.Usage & D3D11_USAGE_DYNAMIC) {
 			D3D11_MAPPED_SUBRESOURCE mapped_buffer{};
@@ -80,6 +212,9 @@ public:
 private:
 	winrt::com_ptr<ID3D11Buffer> resource;
 	D3D11_BUFFER_DESC desc;
+	ConstantBufferRing::Allocation allocation;
+	bool suballocated = false;
+	TrackedMemory memory;
 };
 
 template <typename T>
@@ -102,7 +237,7 @@ class StructuredBuffer
 {
 public:
 	StructuredBuffer(D3D11_BUFFER_DESC const& a_desc, UINT a_count) :
-		desc(a_desc), count(a_count)
+		desc(a_desc), count(a_count), memory(a_desc.ByteWidth)
 	{
 		auto device = reinterpret_cast<ID3D11Device*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().forwarder);
 		DX::ThrowIfFailed(device->CreateBuffer(&desc, nullptr, resource.put()));
@@ -159,13 +294,14 @@ private:
 	winrt::com_ptr<ID3D11Buffer> resource;
 	D3D11_BUFFER_DESC desc;
 	UINT count;
+	TrackedMemory memory;
 };
 
 class Buffer
 {
 public:
 	explicit Buffer(D3D11_BUFFER_DESC const& a_desc, D3D11_SUBRESOURCE_DATA* a_init = nullptr) :
-		desc(a_desc)
+		desc(a_desc), memory(a_desc.ByteWidth)
 	{
 		auto device = reinterpret_cast<ID3D11Device*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().forwarder);
 		DX::ThrowIfFailed(device->CreateBuffer(&desc, a_init, resource.put()));
@@ -186,13 +322,14 @@ public:
 	winrt::com_ptr<ID3D11Buffer> resource;
 	winrt::com_ptr<ID3D11ShaderResourceView> srv;
 	winrt::com_ptr<ID3D11UnorderedAccessView> uav;
+	TrackedMemory memory;
 };
 
 class Texture1D
 {
 public:
 	explicit Texture1D(D3D11_TEXTURE1D_DESC const& a_desc) :
-		desc(a_desc)
+		desc(a_desc), memory(Profiler::GetTextureSize(a_desc.Format, a_desc.Width, 1, 1, a_desc.MipLevels, a_desc.ArraySize))
 	{
 		auto device = reinterpret_cast<ID3D11Device*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().forwarder);
 		DX::ThrowIfFailed(device->CreateTexture1D(&desc, nullptr, resource.put()));
@@ -220,13 +357,14 @@ public:
 	winrt::com_ptr<ID3D11ShaderResourceView> srv;
 	winrt::com_ptr<ID3D11UnorderedAccessView> uav;
 	winrt::com_ptr<ID3D11RenderTargetView> rtv;
+	TrackedMemory memory;
 };
 
 class Texture2D
 {
 public:
 	explicit Texture2D(D3D11_TEXTURE2D_DESC const& a_desc) :
-		desc(a_desc)
+		desc(a_desc), memory(Profiler::GetTextureSize(a_desc.Format, a_desc.Width, a_desc.Height, 1, a_desc.MipLevels, a_desc.ArraySize))
 	{
 		auto device = reinterpret_cast<ID3D11Device*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().forwarder);
 		DX::ThrowIfFailed(device->CreateTexture2D(&desc, nullptr, resource.put()));
@@ -236,6 +374,7 @@ public:
 	{
 		a_resource->GetDesc(&desc);
 		resource.attach(a_resource);
+		memory = TrackedMemory(Profiler::GetTextureSize(desc.Format, desc.Width, desc.Height, 1, desc.MipLevels, desc.ArraySize));
 	}
 
 	void CreateSRV(D3D11_SHADER_RESOURCE_VIEW_DESC const& a_desc)
@@ -267,13 +406,14 @@ public:
 	winrt::com_ptr<ID3D11UnorderedAccessView> uav;
 	winrt::com_ptr<ID3D11RenderTargetView> rtv;
 	winrt::com_ptr<ID3D11DepthStencilView> dsv;
+	TrackedMemory memory;
 };
 
 class Texture3D
 {
 public:
 	explicit Texture3D(D3D11_TEXTURE3D_DESC const& a_desc) :
-		desc(a_desc)
+		desc(a_desc), memory(Profiler::GetTextureSize(a_desc.Format, a_desc.Width, a_desc.Height, a_desc.Depth, a_desc.MipLevels, 1))
 	{
 		auto device = reinterpret_cast<ID3D11Device*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().forwarder);
 		DX::ThrowIfFailed(device->CreateTexture3D(&desc, nullptr, resource.put()));
@@ -299,4 +439,5 @@ public:
 	winrt::com_ptr<ID3D11ShaderResourceView> srv;
 	winrt::com_ptr<ID3D11UnorderedAccessView> uav;
 	winrt::com_ptr<ID3D11RenderTargetView> rtv;
+	TrackedMemory memory;
 };
\ No newline at end of file
@@ -1,7 +1,10 @@
 #include "Deferred.h"
 
+#include "ExtendedRendererState.h"
+#include "Profiler.h"
 #include "ShaderCache.h"
 #include "State.h"
+#include "TexturePool.h"
 #include "TruePBR.h"
 #include "Util.h"
 #include "VariableCache.h"
@@ -160,22 +163,42 @@ void Deferred::SetupResources()
 		texDesc.Format = DXGI_FORMAT_R11G11B10_FLOAT;
 		texDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
 
-		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {
-			.Format = texDesc.Format,
-			.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D,
-			.Texture2D = {
-				.MostDetailedMip = 0,
-				.MipLevels = 1 }
-		};
-		D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {
-			.Format = texDesc.Format,
-			.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2D,
-			.Texture2D = { .MipSlice = 0 }
-		};
+		prevDiffuseAmbientDesc = texDesc;
+	}
+
+	{
+		auto maxTiles = Util::GetScreenDispatchCount(false);
+		uint numTiles = maxTiles.x * maxTiles.y + 1;  // leading tile count
+
+		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc{};
+		srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+		srvDesc.Buffer.FirstElement = 0;
+		srvDesc.Buffer.NumElements = numTiles;
+
+		D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc{};
+		uavDesc.Format = DXGI_FORMAT_UNKNOWN;
+		uavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+		uavDesc.Buffer.FirstElement = 0;
+		uavDesc.Buffer.NumElements = numTiles;
+
+		for (auto& tileList : tileLists) {
+			tileList = new Buffer(StructuredBufferDesc<uint>(numTiles));
+			tileList->CreateSRV(srvDesc);
+			tileList->CreateUAV(uavDesc);
+		}
+
+		D3D11_BUFFER_DESC argsDesc{};
+		argsDesc.Usage = D3D11_USAGE_DEFAULT;
+		argsDesc.BindFlags = D3D11_BIND_UNORDERED_ACCESS;
+		argsDesc.MiscFlags = D3D11_RESOURCE_MISC_DRAWINDIRECT_ARGS;
+		argsDesc.ByteWidth = sizeof(uint) * 3 * kNumTileBuckets;
 
-		prevDiffuseAmbientTexture = new Texture2D(texDesc);
-		prevDiffuseAmbientTexture->CreateSRV(srvDesc);
-		prevDiffuseAmbientTexture->CreateUAV(uavDesc);
+		tileArgs = new Buffer(argsDesc);
+
+		uavDesc.Format = DXGI_FORMAT_R32_UINT;
+		uavDesc.Buffer.NumElements = 3 * kNumTileBuckets;
+		tileArgs->CreateUAV(uavDesc);
 	}
 }
 
@@ -215,7 +238,7 @@ void Deferred::CopyShadowData()
 			perShadow->srv.get(),
 		};
 
-		context->PSSetShaderResources(18, ARRAYSIZE(srvs), srvs);
+		ExtendedRendererState::GetSingleton()->SetPSResources(18, ARRAYSIZE(srvs), srvs);
 	}
 }
 
@@ -240,6 +263,7 @@ void Deferred::EarlyPrepasses()
 
 	for (auto* feature : Feature::GetFeatureList()) {
 		if (feature->loaded) {
+			Profiler::Scope scope(feature);
 			feature->EarlyPrepass();
 		}
 	}
@@ -266,6 +290,7 @@ void Deferred::PrepassPasses()
 	TruePBR::GetSingleton()->PrePass();
 	for (auto* feature : Feature::GetFeatureList()) {
 		if (feature->loaded) {
+			Profiler::Scope scope(feature);
 			feature->Prepass();
 		}
 	}
@@ -374,15 +399,59 @@ void Deferred::DeferredPasses()
 
 	auto skylighting = Skylighting::GetSingleton();
 
+	auto texturePool = TexturePool::GetSingleton();
+
 	auto ssgi = ScreenSpaceGI::GetSingleton();
-	if (ssgi->loaded)
+	if (ssgi->loaded) {
+		Profiler::Scope scope(ssgi);
 		ssgi->DrawSSGI(prevDiffuseAmbientTexture);
+	}
+	// SSGI was the last reader, the ambient composite writes a new one below
+	texturePool->Release(prevDiffuseAmbientTexture);
+	prevDiffuseAmbientTexture = nullptr;
+
 	auto [ssgi_ao, ssgi_y, ssgi_cocg, ssgi_gi_spec] = ssgi->GetOutputTextures();
 	bool ssgi_hq_spec = ssgi->settings.EnableExperimentalSpecularGI;
 
 	auto dispatchCount = Util::GetScreenDispatchCount();
 
+	auto dynamicCubemaps = DynamicCubemaps::GetSingleton();
+
+	// Classify tiles
+	{
+		TracyD3D11Zone(State::GetSingleton()->tracyCtx, "Deferred Tile Classification");
+
+		static constexpr uint resetCount = 0;
+		static constexpr D3D11_BOX countBox = { 0, 0, 0, sizeof(uint), 1, 1 };
+		for (auto tileList : tileLists)
+			context->UpdateSubresource(tileList->resource.get(), 0, &countBox, &resetCount, 0, 0);
+
+		ID3D11ShaderResourceView* srvs[3]{
+			depth.depthSRV,
+			albedo.SRV,
+			dynamicCubemaps->loaded ? reflectance.SRV : nullptr,
+		};
+		context->CSSetShaderResources(0, ARRAYSIZE(srvs), srvs);
+
+		ID3D11UnorderedAccessView* uavs[4]{ tileLists[kSky]->uav.get(), tileLists[kSimple]->uav.get(), tileLists[kFull]->uav.get(), tileArgs->uav.get() };
+		context->CSSetUnorderedAccessViews(0, ARRAYSIZE(uavs), uavs, nullptr);
+
+		context->CSSetShader(GetComputeTileClassify(), nullptr, 0);
+
+		context->Dispatch(dispatchCount.x, dispatchCount.y, 1);
+
+		context->CSSetShader(GetComputeTileArgs(), nullptr, 0);
+		context->Dispatch(1, 1, 1);
+
+		ID3D11UnorderedAccessView* nullUavs[4]{ nullptr, nullptr, nullptr, nullptr };
+		context->CSSetUnorderedAccessViews(0, ARRAYSIZE(nullUavs), nullUavs, nullptr);
+	}
+
 	if (ssgi->loaded) {
+		// Only kept for SSGI to read next frame
+		if (ssgi->settings.Enabled)
+			prevDiffuseAmbientTexture = texturePool->Acquire(prevDiffuseAmbientDesc);
+
 		// Ambient Composite
 		{
 			TracyD3D11Zone(State::GetSingleton()->tracyCtx, "Ambient Composite");
@@ -401,18 +470,21 @@ void Deferred::DeferredPasses()
 
 			context->CSSetShaderResources(0, ARRAYSIZE(srvs), srvs);
 
-			ID3D11UnorderedAccessView* uavs[2]{ main.UAV, prevDiffuseAmbientTexture->uav.get() };
+			ID3D11UnorderedAccessView* uavs[2]{ main.UAV, prevDiffuseAmbientTexture ? prevDiffuseAmbientTexture->uav.get() : nullptr };
 			context->CSSetUnorderedAccessViews(0, ARRAYSIZE(uavs), uavs, nullptr);
 
+			context->CSSetShader(GetComputeAmbientCompositeSky(), nullptr, 0);
+			DispatchTiles(kSky, 9);
+
 			auto shader = interior ? GetComputeAmbientCompositeInterior() : GetComputeAmbientComposite();
 			context->CSSetShader(shader, nullptr, 0);
-
-			context->Dispatch(dispatchCount.x, dispatchCount.y, 1);
+			DispatchTiles(kSimple, 9);
+			DispatchTiles(kFull, 9);
 		}
 
 		// Clear
 		{
-			ID3D11ShaderResourceView* views[6]{ nullptr, nullptr, nullptr, nullptr, nullptr, nullptr };
+			ID3D11ShaderResourceView* views[10]{ nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr };
 			context->CSSetShaderResources(0, ARRAYSIZE(views), views);
 
 			ID3D11UnorderedAccessView* uavs[2]{ nullptr, nullptr };
@@ -423,12 +495,15 @@ void Deferred::DeferredPasses()
 	}
 
 	auto sss = SubsurfaceScattering::GetSingleton();
-	if (sss->loaded)
+	if (sss->loaded) {
+		Profiler::Scope scope(sss);
 		sss->DrawSSS();
+	}
 
-	auto dynamicCubemaps = DynamicCubemaps::GetSingleton();
-	if (dynamicCubemaps->loaded)
+	if (dynamicCubemaps->loaded) {
+		Profiler::Scope scope(dynamicCubemaps);
 		dynamicCubemaps->UpdateCubemap();
+	}
 
 	auto terrainBlending = TerrainBlending::GetSingleton();
 
@@ -462,15 +537,19 @@ void Deferred::DeferredPasses()
 		ID3D11UnorderedAccessView* uavs[3]{ main.UAV, normals.UAV, motionVectors.UAV };
 		context->CSSetUnorderedAccessViews(0, ARRAYSIZE(uavs), uavs, nullptr);
 
+		// Sky tiles have no reflections either
+		context->CSSetShader(GetComputeMainCompositeSimple(), nullptr, 0);
+		DispatchTiles(kSky, 15);
+		DispatchTiles(kSimple, 15);
+
 		auto shader = interior ? GetComputeMainCompositeInterior() : GetComputeMainComposite();
 		context->CSSetShader(shader, nullptr, 0);
-
-		context->Dispatch(dispatchCount.x, dispatchCount.y, 1);
+		DispatchTiles(kFull, 15);
 	}
 
 	// Clear
 	{
-		ID3D11ShaderResourceView* views[10]{ nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr };
+		ID3D11ShaderResourceView* views[16]{};
 		context->CSSetShaderResources(0, ARRAYSIZE(views), views);
 
 		ID3D11UnorderedAccessView* uavs[3]{ nullptr, nullptr, nullptr };
@@ -482,8 +561,23 @@ void Deferred::DeferredPasses()
 		context->CSSetShader(nullptr, nullptr, 0);
 	}
 
-	if (dynamicCubemaps->loaded)
+	if (ssgi->loaded)
+		ssgi->ReleaseOutputs();
+
+	if (dynamicCubemaps->loaded) {
+		Profiler::Scope scope(dynamicCubemaps);
 		dynamicCubemaps->PostDeferred();
+	}
+}
+
+void Deferred::DispatchTiles(TileBucket a_bucket, uint a_listSlot)
+{
+	auto& context = State::GetSingleton()->context;
+
+	ID3D11ShaderResourceView* view = tileLists[a_bucket]->srv.get();
+	context->CSSetShaderResources(a_listSlot, 1, &view);
+
+	context->DispatchIndirect(tileArgs->resource.get(), sizeof(uint) * 3 * a_bucket);
 }
 
 void Deferred::EndDeferred()
@@ -603,6 +697,14 @@ void Deferred::ResetBlendStates()
 
 void Deferred::ClearShaderCache()
 {
+	if (tileClassifyCS) {
+		tileClassifyCS->Release();
+		tileClassifyCS = nullptr;
+	}
+	if (tileArgsCS) {
+		tileArgsCS->Release();
+		tileArgsCS = nullptr;
+	}
 	if (ambientCompositeCS) {
 		ambientCompositeCS->Release();
 		ambientCompositeCS = nullptr;
@@ -619,6 +721,32 @@ void Deferred::ClearShaderCache()
 		mainCompositeInteriorCS->Release();
 		mainCompositeInteriorCS = nullptr;
 	}
+	if (ambientCompositeSkyCS) {
+		ambientCompositeSkyCS->Release();
+		ambientCompositeSkyCS = nullptr;
+	}
+	if (mainCompositeSimpleCS) {
+		mainCompositeSimpleCS->Release();
+		mainCompositeSimpleCS = nullptr;
+	}
+}
+
+ID3D11ComputeShader* Deferred::GetComputeTileClassify()
+{
+	if (!tileClassifyCS) {
+		logger::debug("Compiling DeferredTileClassifyCS");
+		tileClassifyCS = static_cast<ID3D11ComputeShader*>(Util::CompileShader(L"Data\\Shaders\\DeferredTileClassifyCS.hlsl", {}, "cs_5_0"));
+	}
+	return tileClassifyCS;
+}
+
+ID3D11ComputeShader* Deferred::GetComputeTileArgs()
+{
+	if (!tileArgsCS) {
+		logger::debug("Compiling DeferredTileClassifyCS ARGS");
+		tileArgsCS = static_cast<ID3D11ComputeShader*>(Util::CompileShader(L"Data\\Shaders\\DeferredTileClassifyCS.hlsl", { { "ARGS", "" } }, "cs_5_0"));
+	}
+	return tileArgsCS;
 }
 
 ID3D11ComputeShader* Deferred::GetComputeAmbientComposite()
@@ -661,6 +789,25 @@ ID3D11ComputeShader* Deferred::GetComputeAmbientCompositeInterior()
 	return ambientCompositeInteriorCS;
 }
 
+ID3D11ComputeShader* Deferred::GetComputeAmbientCompositeSky()
+{
+	if (!ambientCompositeSkyCS) {
+		logger::debug("Compiling AmbientCompositeCS SKY");
+
+		std::vector<std::pair<const char*, const char*>> defines;
+		defines.push_back({ "SKY", nullptr });
+
+		if (ScreenSpaceGI::GetSingleton()->loaded)
+			defines.push_back({ "SSGI", nullptr });
+
+		if (REL::Module::IsVR())
+			defines.push_back({ "FRAMEBUFFER", nullptr });
+
+		ambientCompositeSkyCS = static_cast<ID3D11ComputeShader*>(Util::CompileShader(L"Data\\Shaders\\AmbientCompositeCS.hlsl", defines, "cs_5_0"));
+	}
+	return ambientCompositeSkyCS;
+}
+
 ID3D11ComputeShader* Deferred::GetComputeMainComposite()
 {
 	if (!mainCompositeCS) {
@@ -707,6 +854,22 @@ ID3D11ComputeShader* Deferred::GetComputeMainCompositeInterior()
 	return mainCompositeInteriorCS;
 }
 
+ID3D11ComputeShader* Deferred::GetComputeMainCompositeSimple()
+{
+	if (!mainCompositeSimpleCS) {
+		logger::debug("Compiling DeferredCompositeCS SIMPLE");
+
+		// No reflective pixels, so the dynamic cubemaps path and everything it pulls in can be left out
+		std::vector<std::pair<const char*, const char*>> defines;
+
+		if (REL::Module::IsVR())
+			defines.push_back({ "FRAMEBUFFER", nullptr });
+
+		mainCompositeSimpleCS = static_cast<ID3D11ComputeShader*>(Util::CompileShader(L"Data\\Shaders\\DeferredCompositeCS.hlsl", defines, "cs_5_0"));
+	}
+	return mainCompositeSimpleCS;
+}
+
 void Deferred::Hooks::Main_RenderShadowMaps::thunk()
 {
 	func();
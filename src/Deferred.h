@@ -32,28 +32,53 @@ public:
 	void PrepassPasses();
 
 	void ClearShaderCache();
+	ID3D11ComputeShader* GetComputeTileClassify();
+	ID3D11ComputeShader* GetComputeTileArgs();
 	ID3D11ComputeShader* GetComputeAmbientComposite();
 	ID3D11ComputeShader* GetComputeAmbientCompositeInterior();
+	ID3D11ComputeShader* GetComputeAmbientCompositeSky();
 	ID3D11ComputeShader* GetComputeMainComposite();
 
 	ID3D11ComputeShader* GetComputeMainCompositeInterior();
+	ID3D11ComputeShader* GetComputeMainCompositeSimple();
 
 	ID3D11BlendState* deferredBlendStates[7][2][13][2];
 	ID3D11BlendState* forwardBlendStates[7][2][13][2];
 
 	RE::RENDER_TARGET forwardRenderTargets[4];
 
+	ID3D11ComputeShader* tileClassifyCS = nullptr;
+	ID3D11ComputeShader* tileArgsCS = nullptr;
+
 	ID3D11ComputeShader* ambientCompositeCS = nullptr;
 	ID3D11ComputeShader* ambientCompositeInteriorCS = nullptr;
+	ID3D11ComputeShader* ambientCompositeSkyCS = nullptr;
 
 	ID3D11ComputeShader* mainCompositeCS = nullptr;
 	ID3D11ComputeShader* mainCompositeInteriorCS = nullptr;
+	ID3D11ComputeShader* mainCompositeSimpleCS = nullptr;
+
+	// Composite tiles bucketed by DeferredTileClassifyCS, each bucket is dispatched indirectly
+	enum TileBucket : uint
+	{
+		kSky,
+		kSimple,
+		kFull,
+		kNumTileBuckets
+	};
+
+	Buffer* tileLists[kNumTileBuckets] = {};
+	Buffer* tileArgs = nullptr;
+
+	void DispatchTiles(TileBucket a_bucket, uint a_listSlot);
 
 	bool inWorld = false;
 	bool inBlendedDecals = false;
 	bool inDecals = false;
 	bool deferredPass = false;
 
+	// Taken from the texture pool by the ambient composite and handed back once SSGI has read it the next frame
+	D3D11_TEXTURE2D_DESC prevDiffuseAmbientDesc{};
 	Texture2D* prevDiffuseAmbientTexture = nullptr;
 
 	ID3D11SamplerState* linearSampler = nullptr;
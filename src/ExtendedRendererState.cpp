@@ -0,0 +1,67 @@
+#include "ExtendedRendererState.h"
+
+void ExtendedRendererState::SetPSResources(uint a_slot, uint a_count, ID3D11ShaderResourceView* const* a_views)
+{
+	assert(a_slot >= FirstPSSlot && a_slot + a_count <= D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT);
+
+	uint begin = a_slot - FirstPSSlot;
+	uint end = begin + a_count;
+	usedBegin = std::min(usedBegin, begin);
+	usedEnd = std::max(usedEnd, end);
+
+	for (uint i = begin; i < end; i++) {
+		pending[i] = a_views[i - begin];
+		forced.set(i);
+	}
+	dirtyBegin = std::min(dirtyBegin, begin);
+	dirtyEnd = std::max(dirtyEnd, end);
+}
+
+void ExtendedRendererState::SetPSResourceIfChanged(uint a_slot, ID3D11ShaderResourceView* a_view)
+{
+	assert(a_slot >= FirstPSSlot && a_slot < D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT);
+
+	uint i = a_slot - FirstPSSlot;
+	usedBegin = std::min(usedBegin, i);
+	usedEnd = std::max(usedEnd, i + 1);
+
+	if (pending[i] == a_view)
+		return;
+
+	pending[i] = a_view;
+	dirtyBegin = std::min(dirtyBegin, i);
+	dirtyEnd = std::max(dirtyEnd, i + 1);
+}
+
+void ExtendedRendererState::Flush(ID3D11DeviceContext* a_context)
+{
+	if (dirtyBegin >= dirtyEnd)
+		return;
+
+	// Views may have been set back to what is bound since they were dirtied
+	auto unchanged = [&](uint i) { return !forced.test(i) && pending[i] == bound[i]; };
+	while (dirtyBegin < dirtyEnd && unchanged(dirtyBegin))
+		dirtyBegin++;
+	while (dirtyEnd > dirtyBegin && unchanged(dirtyEnd - 1))
+		dirtyEnd--;
+
+	if (dirtyBegin < dirtyEnd) {
+		a_context->PSSetShaderResources(FirstPSSlot + dirtyBegin, dirtyEnd - dirtyBegin, pending.data() + dirtyBegin);
+		std::copy(pending.begin() + dirtyBegin, pending.begin() + dirtyEnd, bound.begin() + dirtyBegin);
+	}
+
+	dirtyBegin = NumPSSlots;
+	dirtyEnd = 0;
+	forced.reset();
+}
+
+void ExtendedRendererState::Invalidate()
+{
+	if (usedBegin >= usedEnd)
+		return;
+
+	for (uint i = usedBegin; i < usedEnd; i++)
+		forced.set(i);
+	dirtyBegin = std::min(dirtyBegin, usedBegin);
+	dirtyEnd = std::max(dirtyEnd, usedEnd);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <d3d11.h>
+
+/**
+ * Shadow state for the pixel shader resource slots bound on top of the game's (17 and up).
+ * Views are set here instead of on the context and reach D3D11 as one PSSetShaderResources call over the
+ * changed range right before the game's next draw.
+ * Every slot from FirstPSSlot must go through here, as the flushed range may cover slots in between.
+ */
+class ExtendedRendererState
+{
+public:
+	static ExtendedRendererState* GetSingleton()
+	{
+		static ExtendedRendererState singleton;
+		return &singleton;
+	}
+
+	static constexpr uint FirstPSSlot = 17;
+	static constexpr uint NumPSSlots = D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT - FirstPSSlot;
+
+	/**
+	 * Always rebinds on the next flush, even if the views did not change.
+	 * D3D11 unbinds SRVs whose resource gets bound as a UAV or RTV, which happens to most feature outputs
+	 * between being written and being set here again.
+	 */
+	void SetPSResources(uint a_slot, uint a_count, ID3D11ShaderResourceView* const* a_views);
+
+	void SetPSResource(uint a_slot, ID3D11ShaderResourceView* a_view)
+	{
+		SetPSResources(a_slot, 1, &a_view);
+	}
+
+	// Skips views that are already bound, for per draw bindings of read-only resources such as material textures
+	void SetPSResourceIfChanged(uint a_slot, ID3D11ShaderResourceView* a_view);
+
+	// Called from BSGraphics_SetDirtyStates before each draw
+	void Flush(ID3D11DeviceContext* a_context);
+
+	// Rebinds every used slot on the next flush, in case something else changed them
+	void Invalidate();
+
+private:
+	std::array<ID3D11ShaderResourceView*, NumPSSlots> pending{};
+	std::array<ID3D11ShaderResourceView*, NumPSSlots> bound{};
+	uint dirtyBegin = NumPSSlots;
+	uint dirtyEnd = 0;
+	uint usedBegin = NumPSSlots;
+	uint usedEnd = 0;
+	std::bitset<NumPSSlots> forced;
+};
@@ -37,6 +37,16 @@ struct Feature
 	virtual void DataLoaded() {}
 	virtual void PostPostLoad() {}
 
+	/**
+	 * Quality ladder stepped by the frame budget governor.
+	 * Level 0 is what the user configured and every further level is cheaper.
+	 * Levels only change what is rendered, never the saved settings.
+	 *
+	 * \return number of levels, 1 if the feature cannot be scaled
+	 */
+	virtual uint GetQualityLevelCount() { return 1; }
+	virtual void SetQualityLevel(uint) {}
+
 	void Load(json& o_json);
 	void Save(json& o_json);
 
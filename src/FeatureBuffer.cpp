@@ -11,24 +11,78 @@
 #include "TruePBR.h"
 
 template <class... Ts>
-std::pair<unsigned char*, size_t> _GetFeatureBufferData(Ts... feat_datas)
+struct FeatureBufferLayout
 {
-	size_t totalSize = (... + sizeof(Ts));
-	auto data = new unsigned char[totalSize];
-	size_t offset = 0;
+	static constexpr size_t Size = (... + sizeof(Ts));
 
+	static constexpr std::array<size_t, sizeof...(Ts)> Offsets = [] {
+		std::array<size_t, sizeof...(Ts)> offsets{};
+		size_t offset = 0;
+		size_t index = 0;
+		((offsets[index++] = offset, offset += sizeof(Ts)), ...);
+		return offsets;
+	}();
+};
+
+// Must list the structs in the order of the FeatureData cbuffer
+using Layout = FeatureBufferLayout<
+	GrassLighting::Settings,
+	ExtendedMaterials::Settings,
+	DynamicCubemaps::Settings,
+	TerrainShadows::PerFrame,
+	LightLimitFix::PerFrame,
+	WetnessEffects::PerFrame,
+	Skylighting::SkylightingCB>;
+
+// Registers of the FeatureData cbuffer as declared with packoffset in SharedData.hlsli, followed by its end
+static constexpr size_t FeatureDataRegisters[] = { 0, 2, 4, 6, 9, 12, 24, 33 };
+
+template <size_t I, class T>
+static constexpr bool MatchesFeatureDataRegisters = Layout::Offsets[I] == FeatureDataRegisters[I] * 16 && sizeof(T) == (FeatureDataRegisters[I + 1] - FeatureDataRegisters[I]) * 16;
+
+static_assert(MatchesFeatureDataRegisters<0, GrassLighting::Settings>, "Mismatch with GrassLightingSettings");
+static_assert(MatchesFeatureDataRegisters<1, ExtendedMaterials::Settings>, "Mismatch with CPMSettings");
+static_assert(MatchesFeatureDataRegisters<2, DynamicCubemaps::Settings>, "Mismatch with CubemapCreatorSettings");
+static_assert(MatchesFeatureDataRegisters<3, TerrainShadows::PerFrame>, "Mismatch with TerraOccSettings");
+static_assert(MatchesFeatureDataRegisters<4, LightLimitFix::PerFrame>, "Mismatch with LightLimitFixSettings");
+static_assert(MatchesFeatureDataRegisters<5, WetnessEffects::PerFrame>, "Mismatch with WetnessEffectsSettings");
+static_assert(MatchesFeatureDataRegisters<6, Skylighting::SkylightingCB>, "Mismatch with SkylightingSettings");
+static_assert(std::size(FeatureDataRegisters) == Layout::Offsets.size() + 1, "Every FeatureData struct needs a register");
+static_assert(Layout::Size == FeatureDataRegisters[Layout::Offsets.size()] * 16, "Mismatch with FeatureData");
+
+alignas(16) static unsigned char featureBufferData[Layout::Size];
+static bool featureBufferUploaded = false;
+
+template <class... Ts>
+static bool UpdateSlices(const Ts&... a_featureDatas)
+{
+	using Gathered = FeatureBufferLayout<Ts...>;
+	static_assert(std::is_same_v<Gathered, Layout>, "Feature data does not match the FeatureData layout");
+
+	bool dirty = false;
+	size_t index = 0;
+
+	// A slice is dirty when its feature's data differs from what was last gathered
 	([&] {
-		*((decltype(feat_datas)*)(data + offset)) = feat_datas;
-		offset += sizeof(decltype(feat_datas));
+		auto slice = featureBufferData + Gathered::Offsets[index++];
+		if (std::memcmp(slice, &a_featureDatas, sizeof(Ts))) {
+			std::memcpy(slice, &a_featureDatas, sizeof(Ts));
+			dirty = true;
+		}
 	}(),
 		...);
 
-	return std::make_pair(data, totalSize);
+	return dirty;
 }
 
-std::pair<unsigned char*, size_t> GetFeatureBufferData()
+size_t GetFeatureBufferSize()
 {
-	return _GetFeatureBufferData(
+	return Layout::Size;
+}
+
+bool UpdateFeatureBufferData()
+{
+	bool dirty = UpdateSlices(
 		GrassLighting::GetSingleton()->settings,
 		ExtendedMaterials::GetSingleton()->settings,
 		DynamicCubemaps::GetSingleton()->settings,
@@ -36,4 +90,14 @@ std::pair<unsigned char*, size_t> GetFeatureBufferData()
 		LightLimitFix::GetSingleton()->GetCommonBufferData(),
 		WetnessEffects::GetSingleton()->GetCommonBufferData(),
 		Skylighting::GetSingleton()->GetCommonBufferData());
-}
\ No newline at end of file
+
+	// The constant buffer starts out undefined, so the first update always uploads
+	dirty |= !featureBufferUploaded;
+	featureBufferUploaded = true;
+	return dirty;
+}
+
+const void* GetFeatureBufferData()
+{
+	return featureBufferData;
+}
@@ -1,3 +1,17 @@
 #pragma once
 
-std::pair<unsigned char*, size_t> GetFeatureBufferData();
\ No newline at end of file
+/**
+ * CPU copy of the FeatureData cbuffer (SharedData.hlsli, b6).
+ * The layout is fixed at compile time and the copy persists across frames, each feature's slice is only
+ * rewritten when its data changed.
+ */
+size_t GetFeatureBufferSize();
+
+/**
+ * Gathers the current data of every feature into the persistent copy.
+ *
+ * \return true if any slice changed since the last call and the copy needs uploading
+ */
+bool UpdateFeatureBufferData();
+
+const void* GetFeatureBufferData();
@@ -3,6 +3,7 @@
 #include "State.h"
 
 #include "Deferred.h"
+#include "ExtendedRendererState.h"
 #include "Util.h"
 #include "VariableCache.h"
 
@@ -52,7 +53,7 @@ void CloudShadows::SkyShaderHacks()
 		context->OMSetBlendState(cloudShadowBlendState, blendFactor, sampleMask);
 
 		auto cubemapDepth = renderer->GetDepthStencilData().depthStencils[RE::RENDER_TARGETS_DEPTHSTENCIL::kCUBEMAP_REFLECTIONS];
-		context->PSSetShaderResources(17, 1, &cubemapDepth.depthSRV);
+		ExtendedRendererState::GetSingleton()->SetPSResource(17, cubemapDepth.depthSRV);
 
 		overrideSky = false;
 	}
@@ -83,7 +84,7 @@ void CloudShadows::EarlyPrepass()
 	auto& context = State::GetSingleton()->context;
 
 	ID3D11ShaderResourceView* srv = texCubemapCloudOcc->srv.get();
-	context->PSSetShaderResources(25, 1, &srv);
+	ExtendedRendererState::GetSingleton()->SetPSResource(25, srv);
 	context->CSSetShaderResources(25, 1, &srv);
 }
 
@@ -1,18 +1,24 @@
 #include "DynamicCubemaps.h"
+#include "ExtendedRendererState.h"
 #include "ShaderCache.h"
 
 #include "State.h"
 #include "Util.h"
 
 #include <DDSTextureLoader.h>
-#include <DirectXTex.h>
 
 constexpr auto MIPLEVELS = 8;
 
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(
 	DynamicCubemaps::Settings,
 	EnabledSSR,
-	EnabledCreator);
+	EnabledCreator,
+	FacesPerFrame);
+
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(
+	DynamicCubemaps::CacheSettings,
+	LocationCacheSize,
+	SaveToDisk);
 
 std::vector<std::pair<std::string_view, std::string_view>> DynamicCubemaps::GetShaderDefineOptions()
 {
@@ -45,6 +51,30 @@ void DynamicCubemaps::DrawSettings()
 			ImGui::TreePop();
 		}
 
+		if (ImGui::TreeNodeEx("Updates", ImGuiTreeNodeFlags_DefaultOpen)) {
+			ImGui::SliderInt("Faces Per Frame", (int*)&settings.FacesPerFrame, 1, 6, "%d", ImGuiSliderFlags_AlwaysClamp);
+			if (auto _tt = Util::HoverTooltipWrapper())
+				ImGui::Text(
+					"Number of cubemap faces inferred or filtered each frame. "
+					"Faces facing the direction of camera movement are updated first. "
+					"Lower values spread the cost over more frames.");
+
+			if (ImGui::SliderInt("Location Cache Size", (int*)&cacheSettings.LocationCacheSize, 0, 32, "%d", ImGuiSliderFlags_AlwaysClamp))
+				TrimLocationCache();
+			if (auto _tt = Util::HoverTooltipWrapper())
+				ImGui::Text(
+					"Number of converged cubemaps kept in VRAM, per cell and position. "
+					"Returning to a cached location starts from the cached cubemap instead of converging again. "
+					"Set to 0 to disable.");
+
+			ImGui::Checkbox("Save Cache To Disk", &cacheSettings.SaveToDisk);
+			if (auto _tt = Util::HoverTooltipWrapper())
+				ImGui::Text("Also keeps filtered cubemaps in %s as BC6H, so they survive restarts.", locationCachePath.c_str());
+
+			ImGui::Text(std::format("Cached locations: {}", locationCache.size()).c_str());
+			ImGui::TreePop();
+		}
+
 		if (ImGui::TreeNodeEx("Dynamic Cubemap Creator", ImGuiTreeNodeFlags_DefaultOpen)) {
 			ImGui::Text("You must enable creator mode by adding the shader define CREATOR");
 			ImGui::Checkbox("Enable Creator", reinterpret_cast<bool*>(&settings.EnabledCreator));
@@ -142,6 +172,9 @@ void DynamicCubemaps::DrawSettings()
 void DynamicCubemaps::LoadSettings(json& o_json)
 {
 	settings = o_json;
+	if (o_json.contains("LocationCache"))
+		cacheSettings = o_json["LocationCache"];
+	TrimLocationCache();
 	Util::LoadGameSettings(SSRSettings);
 	if (REL::Module::IsVR()) {
 		Util::LoadGameSettings(iniVRCubeMapSettings);
@@ -152,6 +185,7 @@ void DynamicCubemaps::LoadSettings(json& o_json)
 void DynamicCubemaps::SaveSettings(json& o_json)
 {
 	o_json = settings;
+	o_json["LocationCache"] = cacheSettings;
 	Util::SaveGameSettings(SSRSettings);
 	if (REL::Module::IsVR()) {
 		Util::SaveGameSettings(iniVRCubeMapSettings);
@@ -161,6 +195,8 @@ void DynamicCubemaps::SaveSettings(json& o_json)
 void DynamicCubemaps::RestoreDefaultSettings()
 {
 	settings = {};
+	cacheSettings = {};
+	TrimLocationCache();
 	Util::ResetGameSettingsToDefaults(SSRSettings);
 	if (REL::Module::IsVR()) {
 		Util::ResetGameSettingsToDefaults(iniVRCubeMapSettings);
@@ -200,12 +236,21 @@ void DynamicCubemaps::PostPostLoad()
 
 RE::BSEventNotifyControl MenuOpenCloseEventHandler::ProcessEvent(const RE::MenuOpenCloseEvent* a_event, RE::BSTEventSource<RE::MenuOpenCloseEvent>*)
 {
-	// When entering a new cell, reset the capture
+	// When entering a new cell, reset the capture or start from the cached location.
+	// Locations are resolved here while the player is still in place, the cubemaps are copied on the next update.
 	if (a_event->menuName == RE::LoadingMenu::MENU_NAME) {
-		if (!a_event->opening) {
-			auto dynamicCubemaps = DynamicCubemaps::GetSingleton();
-			dynamicCubemaps->resetCapture[0] = true;
-			dynamicCubemaps->resetCapture[1] = true;
+		auto dynamicCubemaps = DynamicCubemaps::GetSingleton();
+		DynamicCubemaps::LocationKey key;
+		bool validLocation = DynamicCubemaps::GetCurrentLocation(key);
+
+		std::lock_guard lock(dynamicCubemaps->queuedLocationMutex);
+		if (a_event->opening) {
+			if (validLocation)
+				dynamicCubemaps->queuedStoreLocation = key;
+		} else {
+			dynamicCubemaps->queuedResetCapture = true;
+			if (validLocation)
+				dynamicCubemaps->queuedRestoreLocation = key;
 		}
 	}
 	return RE::BSEventNotifyControl::kContinue;
@@ -246,6 +291,10 @@ void DynamicCubemaps::ClearShaderCache()
 		specularIrradianceCS->Release();
 		specularIrradianceCS = nullptr;
 	}
+	if (mipChainCS) {
+		mipChainCS->Release();
+		mipChainCS = nullptr;
+	}
 }
 
 ID3D11ComputeShader* DynamicCubemaps::GetComputeShaderUpdate()
@@ -293,6 +342,15 @@ ID3D11ComputeShader* DynamicCubemaps::GetComputeShaderSpecularIrradiance()
 	return specularIrradianceCS;
 }
 
+ID3D11ComputeShader* DynamicCubemaps::GetComputeShaderMipChain()
+{
+	if (!mipChainCS) {
+		logger::debug("Compiling MipChainCS");
+		mipChainCS = static_cast<ID3D11ComputeShader*>(Util::CompileShader(L"Data\\Shaders\\DynamicCubemaps\\MipChainCS.hlsl", {}, "cs_5_0"));
+	}
+	return mipChainCS;
+}
+
 void DynamicCubemaps::UpdateCubemapCapture(bool a_reflections)
 {
 	auto renderer = RE::BSGraphics::Renderer::GetSingleton();
@@ -324,13 +382,14 @@ void DynamicCubemaps::UpdateCubemapCapture(bool a_reflections)
 		context->ClearUnorderedAccessViewFloat(uavs[1], clearColor);
 		context->ClearUnorderedAccessViewFloat(uavs[2], clearColor);
 		resetCapture[index] = false;
+		capturesSinceReset[index] = 0;
 	}
+	capturesSinceReset[index]++;
 
 	context->CSSetUnorderedAccessViews(0, 3, uavs, nullptr);
 
 	UpdateCubemapCB updateData{};
 
-	static float3 cameraPreviousPosAdjust[2] = { { 0, 0, 0 }, { 0, 0, 0 } };
 	updateData.CameraPreviousPosAdjust = cameraPreviousPosAdjust[index];
 
 	auto eyePosition = Util::GetEyePosition(0);
@@ -364,9 +423,81 @@ void DynamicCubemaps::UpdateCubemapCapture(bool a_reflections)
 
 	ID3D11SamplerState* nullSampler = { nullptr };
 	context->CSSetSamplers(0, 1, &nullSampler);
+
+	// Inferrence of any face samples the coarse mips of every face
+	if (a_reflections)
+		GenerateMipChain(envCaptureReflectionsTexture, envCaptureReflectionsMips, 0, 6);
+	else
+		GenerateMipChain(envCaptureTexture, envCaptureMips, 0, 6);
+}
+
+void DynamicCubemaps::CreateMipChainViews(Texture2D* a_texture, MipChainViews& a_views)
+{
+	auto& device = State::GetSingleton()->device;
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Format = a_texture->desc.Format;
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+	srvDesc.Texture2DArray.MostDetailedMip = 0;
+	srvDesc.Texture2DArray.MipLevels = 1;
+	srvDesc.Texture2DArray.FirstArraySlice = 0;
+	srvDesc.Texture2DArray.ArraySize = a_texture->desc.ArraySize;
+	DX::ThrowIfFailed(device->CreateShaderResourceView(a_texture->resource.get(), &srvDesc, a_views.srv.put()));
+
+	D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+	uavDesc.Format = a_texture->desc.Format;
+	uavDesc.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2DARRAY;
+	uavDesc.Texture2DArray.FirstArraySlice = 0;
+	uavDesc.Texture2DArray.ArraySize = a_texture->desc.ArraySize;
+
+	for (std::uint32_t level = 1; level < MIPLEVELS; ++level) {
+		uavDesc.Texture2DArray.MipSlice = level;
+		DX::ThrowIfFailed(device->CreateUnorderedAccessView(a_texture->resource.get(), &uavDesc, a_views.uavs[level - 1].put()));
+	}
+}
+
+void DynamicCubemaps::GenerateMipChain(Texture2D* a_texture, MipChainViews& a_views, uint a_firstFace, uint a_faceCount)
+{
+	auto& context = State::GetSingleton()->context;
+
+	if (!singlePassMips || !GetComputeShaderMipChain()) {
+		context->GenerateMips(a_texture->srv.get());
+		return;
+	}
+
+	FaceCB faceData{ a_firstFace };
+	faceCB->Update(faceData);
+	faceCB->CSSet(context, 0);
+
+	ID3D11ShaderResourceView* srv = a_views.srv.get();
+	context->CSSetShaderResources(0, 1, &srv);
+
+	ID3D11UnorderedAccessView* uavs[MIPLEVELS - 1];
+	for (uint i = 0; i < MIPLEVELS - 1; i++)
+		uavs[i] = a_views.uavs[i].get();
+	context->CSSetUnorderedAccessViews(0, MIPLEVELS - 1, uavs, nullptr);
+
+	context->CSSetSamplers(0, 1, &computeSampler);
+	context->CSSetShader(GetComputeShaderMipChain(), nullptr, 0);
+
+	context->Dispatch(1, 1, a_faceCount);
+
+	std::fill(std::begin(uavs), std::end(uavs), nullptr);
+	context->CSSetUnorderedAccessViews(0, MIPLEVELS - 1, uavs, nullptr);
+
+	srv = nullptr;
+	context->CSSetShaderResources(0, 1, &srv);
+
+	ID3D11Buffer* nullBuffer = nullptr;
+	context->CSSetConstantBuffers(0, 1, &nullBuffer);
+
+	ID3D11SamplerState* nullSampler = nullptr;
+	context->CSSetSamplers(0, 1, &nullSampler);
+
+	context->CSSetShader(nullptr, nullptr, 0);
 }
 
-void DynamicCubemaps::Inferrence(bool a_reflections)
+void DynamicCubemaps::Inferrence(bool a_reflections, uint a_face)
 {
 	auto renderer = RE::BSGraphics::Renderer::GetSingleton();
 	auto& context = State::GetSingleton()->context;
@@ -376,7 +507,9 @@ void DynamicCubemaps::Inferrence(bool a_reflections)
 
 	context->CSSetUnorderedAccessViews(0, 1, &uav, nullptr);
 
-	context->GenerateMips((a_reflections ? envCaptureReflectionsTexture : envCaptureTexture)->srv.get());
+	FaceCB faceData{ a_face };
+	faceCB->Update(faceData);
+	faceCB->CSSet(context, 0);
 
 	auto& cubemap = renderer->GetRendererData().cubemapRenderTargets[RE::RENDER_TARGETS_CUBEMAP::kREFLECTIONS];
 
@@ -387,7 +520,7 @@ void DynamicCubemaps::Inferrence(bool a_reflections)
 
 	context->CSSetShader(a_reflections ? GetComputeShaderInferrenceReflections() : GetComputeShaderInferrence(), nullptr, 0);
 
-	context->Dispatch((uint32_t)std::ceil(envCaptureTexture->desc.Width / 8.0f), (uint32_t)std::ceil(envCaptureTexture->desc.Height / 8.0f), 6);
+	context->Dispatch((uint32_t)std::ceil(envCaptureTexture->desc.Width / 8.0f), (uint32_t)std::ceil(envCaptureTexture->desc.Height / 8.0f), 1);
 
 	srvs[0] = nullptr;
 	srvs[1] = nullptr;
@@ -402,57 +535,77 @@ void DynamicCubemaps::Inferrence(bool a_reflections)
 
 	ID3D11SamplerState* sampler = nullptr;
 	context->CSSetSamplers(0, 1, &sampler);
+
+	ID3D11Buffer* nullBuffer = nullptr;
+	context->CSSetConstantBuffers(0, 1, &nullBuffer);
 }
 
-void DynamicCubemaps::Irradiance(bool a_reflections)
+void DynamicCubemaps::Irradiance(bool a_reflections, uint a_face)
 {
 	auto& context = State::GetSingleton()->context;
 
 	// Copy cubemap to other resources
-	for (uint face = 0; face < 6; face++) {
-		uint srcSubresourceIndex = D3D11CalcSubresource(0, face, MIPLEVELS);
-		context->CopySubresourceRegion(a_reflections ? envReflectionsTexture->resource.get() : envTexture->resource.get(), D3D11CalcSubresource(0, face, MIPLEVELS), 0, 0, 0, envInferredTexture->resource.get(), srcSubresourceIndex, nullptr);
-	}
+	uint subresourceIndex = D3D11CalcSubresource(0, a_face, MIPLEVELS);
+	context->CopySubresourceRegion(a_reflections ? envReflectionsTexture->resource.get() : envTexture->resource.get(), subresourceIndex, 0, 0, 0, envInferredTexture->resource.get(), subresourceIndex, nullptr);
 
-	// Compute pre-filtered specular environment map.
+	// Compute pre-filtered specular environment map, every mip level in one dispatch.
 	{
 		auto srv = envInferredTexture->srv.get();
-		context->GenerateMips(srv);
 
 		context->CSSetShaderResources(0, 1, &srv);
 		context->CSSetSamplers(0, 1, &computeSampler);
 		context->CSSetShader(GetComputeShaderSpecularIrradiance(), nullptr, 0);
 
-		ID3D11Buffer* buffer = spmapCB->CB();
-		context->CSSetConstantBuffers(0, 1, &buffer);
+		FaceCB faceData{ a_face };
+		faceCB->Update(faceData);
+		faceCB->CSSet(context, 0);
 
-		float const delta_roughness = 1.0f / std::max(float(MIPLEVELS - 1), 1.0f);
+		context->CSSetUnorderedAccessViews(0, MIPLEVELS - 1, a_reflections ? uavReflectionsArray : uavArray, nullptr);
 
+		// Groups are laid out level after level, see SpecularIrradianceCS.hlsl
+		UINT numGroups = 0;
 		std::uint32_t size = std::max(envTexture->desc.Width, envTexture->desc.Height) / 2;
-
-		for (std::uint32_t level = 1; level < MIPLEVELS; level++, size /= 2) {
-			const UINT numGroups = (UINT)std::max(1u, size / 8);
-
-			const SpecularMapFilterSettingsCB spmapConstants = { level * delta_roughness };
-			spmapCB->Update(spmapConstants);
-
-			auto uav = a_reflections ? uavReflectionsArray[level - 1] : uavArray[level - 1];
-
-			context->CSSetUnorderedAccessViews(0, 1, &uav, nullptr);
-			context->Dispatch(numGroups, numGroups, 6);
+		for (std::uint32_t level = 1; level < MIPLEVELS; level++, size = std::max(1u, size / 2)) {
+			const UINT groupsPerRow = (size + 7) / 8;
+			numGroups += groupsPerRow * groupsPerRow;
 		}
+
+		context->Dispatch(numGroups, 1, 1);
 	}
 
 	ID3D11ShaderResourceView* nullSRV = { nullptr };
 	ID3D11SamplerState* nullSampler = { nullptr };
 	ID3D11Buffer* nullBuffer = { nullptr };
-	ID3D11UnorderedAccessView* nullUAV = { nullptr };
+	ID3D11UnorderedAccessView* nullUAVs[MIPLEVELS - 1] = {};
 
 	context->CSSetShaderResources(0, 1, &nullSRV);
 	context->CSSetSamplers(0, 1, &nullSampler);
 	context->CSSetShader(nullptr, 0, 0);
 	context->CSSetConstantBuffers(0, 1, &nullBuffer);
-	context->CSSetUnorderedAccessViews(0, 1, &nullUAV, nullptr);
+	context->CSSetUnorderedAccessViews(0, MIPLEVELS - 1, nullUAVs, nullptr);
+}
+
+uint DynamicCubemaps::GetNextFace(uint a_pendingFaces, const float3& a_motion)
+{
+	// Face content looks along the negated face normal, see UpdateCubemapCS.hlsl
+	static const float3 faceNormals[6] = {
+		{ 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 }
+	};
+
+	uint bestFace = 0;
+	float bestScore = -FLT_MAX;
+	for (uint face = 0; face < 6; face++) {
+		if (!(a_pendingFaces & (1u << face)))
+			continue;
+
+		// Faces looking towards the camera movement change the most. Ties keep the natural order.
+		float score = -faceNormals[face].Dot(a_motion);
+		if (score > bestScore) {
+			bestScore = score;
+			bestFace = face;
+		}
+	}
+	return bestFace;
 }
 
 void DynamicCubemaps::UpdateCubemap()
@@ -467,48 +620,313 @@ void DynamicCubemaps::UpdateCubemap()
 		recompileFlag = false;
 	}
 
-	switch (nextTask) {
-	case NextTask::kCapture:
-		UpdateCubemapCapture(false);
-		nextTask = NextTask::kInferrence;
-		break;
+	auto eyePosition = Util::GetEyePosition(0);
+	float3 eyePositionF = { eyePosition.x, eyePosition.y, eyePosition.z };
+	float3 motion = eyePositionF - previousEyePosition;
+	previousEyePosition = eyePositionF;
 
-	case NextTask::kInferrence:
-		nextTask = NextTask::kIrradiance;
-		Inferrence(false);
-		break;
+	std::optional<LocationKey> storeLocation;
+	std::optional<LocationKey> restoreLocation;
+	bool reset = false;
+	{
+		std::lock_guard lock(queuedLocationMutex);
+		storeLocation = std::exchange(queuedStoreLocation, std::nullopt);
+		restoreLocation = std::exchange(queuedRestoreLocation, std::nullopt);
+		reset = std::exchange(queuedResetCapture, false);
+	}
 
-	case NextTask::kIrradiance:
-		if (activeReflections)
-			nextTask = NextTask::kCapture2;
-		else
-			nextTask = NextTask::kCapture;
-		Irradiance(false);
-		break;
+	if (storeLocation)
+		StoreLocation(*storeLocation);
 
-	case NextTask::kCapture2:
-		UpdateCubemapCapture(true);
-		nextTask = NextTask::kInferrence2;
-		break;
+	if (reset) {
+		resetCapture[0] = true;
+		resetCapture[1] = true;
+	}
 
-	case NextTask::kInferrence2:
-		Inferrence(true);
-		nextTask = NextTask::kIrradiance2;
-		break;
+	if (restoreLocation && RestoreLocation(*restoreLocation)) {
+		pendingFaces = 0;
+		pendingFilterFaces = 0;
+	}
 
-	case NextTask::kIrradiance2:
-		nextTask = NextTask::kCapture;
-		Irradiance(true);
-		break;
+	UpdateLocationDiskCache();
+
+	// Start a new cycle by capturing the next cubemap, faces are inferred and filtered over the following frames
+	if ((!pendingFaces && !pendingFilterFaces) || holdFaceUpdates) {
+		if (holdFaceUpdates)
+			holdFaceUpdates--;
+		updatingReflections = activeReflections && !updatingReflections;
+		UpdateCubemapCapture(updatingReflections);
+		pendingFaces = 0x3F;
+		pendingFilterFaces = 0;
+		return;
+	}
+
+	if (qualityLevel >= 2 && (RE::BSGraphics::State::GetSingleton()->frameCount & 1))
+		return;
+
+	const uint facesPerFrame = std::clamp(settings.FacesPerFrame >> std::min(qualityLevel, 1u), 1u, 6u);
+	for (uint i = 0; i < facesPerFrame && (pendingFaces || pendingFilterFaces); i++) {
+		if (pendingFaces) {
+			uint face = GetNextFace(pendingFaces, motion);
+			pendingFaces &= ~(1u << face);
+
+			Inferrence(updatingReflections, face);
+
+			// Every face now comes from the same capture, coarse mips are rebuilt for the whole cube
+			if (!pendingFaces) {
+				GenerateMipChain(envInferredTexture, envInferredMips, 0, 6);
+				pendingFilterFaces = 0x3F;
+			}
+		} else {
+			uint face = GetNextFace(pendingFilterFaces, motion);
+			pendingFilterFaces &= ~(1u << face);
+
+			Irradiance(updatingReflections, face);
+		}
 	}
 }
 
-void DynamicCubemaps::PostDeferred()
+bool DynamicCubemaps::GetCurrentLocation(LocationKey& a_key)
+{
+	auto player = RE::PlayerCharacter::GetSingleton();
+	if (!player)
+		return false;
+
+	auto cell = player->GetParentCell();
+	if (!cell)
+		return false;
+
+	if (cell->IsInteriorCell()) {
+		a_key.formID = cell->GetFormID();
+	} else if (auto worldspace = player->GetWorldspace()) {
+		a_key.formID = worldspace->GetFormID();
+	} else {
+		return false;
+	}
+
+	auto position = player->GetPosition();
+	a_key.x = (int)std::floor(position.x / LOCATION_BUCKET_SIZE);
+	a_key.y = (int)std::floor(position.y / LOCATION_BUCKET_SIZE);
+	return true;
+}
+
+std::array<Texture2D*, 4> DynamicCubemaps::GetLocationTextures(bool a_reflections)
 {
+	if (a_reflections)
+		return { envCaptureReflectionsTexture, envCaptureRawReflectionsTexture, envCapturePositionReflectionsTexture, envReflectionsTexture };
+	return { envCaptureTexture, envCaptureRawTexture, envCapturePositionTexture, envTexture };
+}
+
+void DynamicCubemaps::StoreLocation(const LocationKey& a_key)
+{
+	// Only converged cubemaps are worth keeping
+	if (!cacheSettings.LocationCacheSize || capturesSinceReset[0] < MIN_CACHED_CAPTURES)
+		return;
+
+	auto& context = State::GetSingleton()->context;
+
+	auto it = std::ranges::find_if(locationCache, [&](const CachedLocation& entry) { return entry.key == a_key; });
+	if (it == locationCache.end()) {
+		if (locationCache.size() < cacheSettings.LocationCacheSize) {
+			locationCache.emplace_back();
+			it = locationCache.end() - 1;
+		} else {
+			// Reuse the textures of the least recently used location
+			it = std::ranges::min_element(locationCache, {}, &CachedLocation::lastUsed);
+		}
+	}
+
+	it->key = a_key;
+	it->lastUsed = ++locationCacheClock;
+	it->hasReflections = capturesSinceReset[1] >= MIN_CACHED_CAPTURES;
+
+	for (uint index = 0; index < (it->hasReflections ? 2u : 1u); index++) {
+		auto textures = GetLocationTextures(index == 1);
+		for (uint i = 0; i < textures.size(); i++) {
+			if (!it->textures[index][i])
+				it->textures[index][i] = std::make_unique<Texture2D>(textures[i]->desc);
+			context->CopyResource(it->textures[index][i]->resource.get(), textures[i]->resource.get());
+		}
+		it->cameraPreviousPosAdjust[index] = cameraPreviousPosAdjust[index];
+	}
+
+	if (cacheSettings.SaveToDisk)
+		SaveLocationToDisk(a_key);
+}
+
+bool DynamicCubemaps::RestoreLocation(const LocationKey& a_key)
+{
+	if (!cacheSettings.LocationCacheSize)
+		return false;
+
+	// A disk load still in flight belongs to the previous location
+	pendingLoad = {};
+
+	auto it = std::ranges::find_if(locationCache, [&](const CachedLocation& entry) { return entry.key == a_key; });
+	if (it == locationCache.end()) {
+		// Applied by UpdateLocationDiskCache once the worker has decompressed it
+		if (cacheSettings.SaveToDisk)
+			LoadLocationFromDisk(a_key);
+		return false;
+	}
+
+	auto& context = State::GetSingleton()->context;
+
+	it->lastUsed = ++locationCacheClock;
+
+	for (uint index = 0; index < (it->hasReflections ? 2u : 1u); index++) {
+		auto textures = GetLocationTextures(index == 1);
+		for (uint i = 0; i < textures.size(); i++)
+			context->CopyResource(textures[i]->resource.get(), it->textures[index][i]->resource.get());
+
+		// Captured positions are relative to the camera at the time they were stored
+		cameraPreviousPosAdjust[index] = it->cameraPreviousPosAdjust[index];
+		resetCapture[index] = false;
+		capturesSinceReset[index] = MIN_CACHED_CAPTURES;
+	}
+
+	return true;
+}
+
+std::string DynamicCubemaps::GetLocationCacheFile(const LocationKey& a_key)
+{
+	return std::format("{}\\{:08X}_{}_{}.dds", locationCachePath, a_key.formID, a_key.x, a_key.y);
+}
+
+void DynamicCubemaps::TrimLocationCache()
+{
+	while (locationCache.size() > cacheSettings.LocationCacheSize)
+		locationCache.erase(std::ranges::min_element(locationCache, {}, &CachedLocation::lastUsed));
+}
+
+void DynamicCubemaps::SaveLocationToDisk(const LocationKey& a_key)
+{
+	auto& device = State::GetSingleton()->device;
+	auto& context = State::GetSingleton()->context;
+
+	if (!locationReadbackTexture) {
+		D3D11_TEXTURE2D_DESC texDesc = envTexture->desc;
+		texDesc.Usage = D3D11_USAGE_STAGING;
+		texDesc.BindFlags = 0;
+		texDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+		texDesc.MiscFlags &= D3D11_RESOURCE_MISC_TEXTURECUBE;
+
+		if (FAILED(device->CreateTexture2D(&texDesc, nullptr, locationReadbackTexture.put()))) {
+			logger::warn("Failed to create the readback texture for the location cache");
+			return;
+		}
+	}
+
+	// Mapped by UpdateLocationDiskCache once the copy has finished, a newer save replaces a pending one
+	context->CopyResource(locationReadbackTexture.get(), envTexture->resource.get());
+	pendingSaveFile = GetLocationCacheFile(a_key);
+}
+
+bool DynamicCubemaps::LoadLocationFromDisk(const LocationKey& a_key)
+{
+	auto path = std::filesystem::path(GetLocationCacheFile(a_key));
+	if (!std::filesystem::exists(path))
+		return false;
+
+	// Reading and BC6H decompression are slow, keep them off the render thread
+	pendingLoad = locationCacheWorker.submit([path, texDesc = envTexture->desc]() {
+		DirectX::TexMetadata metadata;
+		DirectX::ScratchImage image;
+		DX::ThrowIfFailed(DirectX::LoadFromDDSFile(path.c_str(), DirectX::DDS_FLAGS_NONE, &metadata, image));
+
+		DirectX::ScratchImage decompressed;
+		if (metadata.width != texDesc.Width || metadata.height != texDesc.Height ||
+			metadata.mipLevels != texDesc.MipLevels || metadata.arraySize != texDesc.ArraySize) {
+			logger::info("Ignoring cached cubemap {} with a different layout", path.string());
+			return decompressed;
+		}
+
+		DX::ThrowIfFailed(DirectX::Decompress(image.GetImages(), image.GetImageCount(), metadata, texDesc.Format, decompressed));
+		return decompressed;
+	});
+	return true;
+}
+
+void DynamicCubemaps::UpdateLocationDiskCache()
+{
+	auto& device = State::GetSingleton()->device;
 	auto& context = State::GetSingleton()->context;
 
+	if (pendingLoad.valid() && pendingLoad.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+		try {
+			auto image = pendingLoad.get();
+			if (image.GetImageCount()) {
+				winrt::com_ptr<ID3D11Resource> resource;
+				DX::ThrowIfFailed(DirectX::CreateTexture(device, image.GetImages(), image.GetImageCount(), image.GetMetadata(), resource.put()));
+				context->CopyResource(envTexture->resource.get(), resource.get());
+
+				// Only the filtered cubemap is on disk, let the capture catch up before it is overwritten
+				holdFaceUpdates = DISK_RESTORE_HOLD_CAPTURES;
+				pendingFaces = 0;
+				pendingFilterFaces = 0;
+			}
+		} catch (const std::exception& e) {
+			logger::error("Failed to load cached cubemap: {}", e.what());
+		}
+	}
+
+	if (pendingSaveFile) {
+		// Every subresource is written by the same copy, once the first one maps without waiting all of them are ready
+		D3D11_MAPPED_SUBRESOURCE mapped;
+		HRESULT hr = context->Map(locationReadbackTexture.get(), 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped);
+		if (hr == DXGI_ERROR_WAS_STILL_DRAWING)
+			return;
+
+		auto path = *pendingSaveFile;
+		pendingSaveFile.reset();
+
+		if (FAILED(hr)) {
+			logger::warn("Failed to read back cubemap for the location cache");
+			return;
+		}
+		context->Unmap(locationReadbackTexture.get(), 0);
+
+		auto& texDesc = envTexture->desc;
+		auto image = std::make_shared<DirectX::ScratchImage>();
+		try {
+			DX::ThrowIfFailed(image->InitializeCube(texDesc.Format, texDesc.Width, texDesc.Height, texDesc.ArraySize / 6, texDesc.MipLevels));
+
+			for (uint item = 0; item < texDesc.ArraySize; item++) {
+				for (uint level = 0; level < texDesc.MipLevels; level++) {
+					uint subresource = D3D11CalcSubresource(level, item, texDesc.MipLevels);
+					DX::ThrowIfFailed(context->Map(locationReadbackTexture.get(), subresource, D3D11_MAP_READ, 0, &mapped));
+
+					auto dest = image->GetImage(level, item, 0);
+					for (size_t row = 0; row < dest->height; row++)
+						std::memcpy(dest->pixels + row * dest->rowPitch, static_cast<uint8_t*>(mapped.pData) + row * mapped.RowPitch, dest->rowPitch);
+
+					context->Unmap(locationReadbackTexture.get(), subresource);
+				}
+			}
+		} catch (const std::exception& e) {
+			logger::error("Failed to read back cubemap for the location cache: {}", e.what());
+			return;
+		}
+
+		// BC6H compression is slow on the CPU, keep it off the render thread
+		locationCacheWorker.push_task([image, path, directory = locationCachePath]() {
+			try {
+				std::filesystem::create_directories(directory);
+
+				DirectX::ScratchImage compressed;
+				DX::ThrowIfFailed(DirectX::Compress(image->GetImages(), image->GetImageCount(), image->GetMetadata(), DXGI_FORMAT_BC6H_UF16, DirectX::TEX_COMPRESS_DEFAULT, 0.0f, compressed));
+				DX::ThrowIfFailed(SaveToDDSFile(compressed.GetImages(), compressed.GetImageCount(), compressed.GetMetadata(), DirectX::DDS_FLAGS::DDS_FLAGS_NONE, std::filesystem::path(path).c_str()));
+			} catch (const std::exception& e) {
+				logger::error("Failed to save cached cubemap {}: {}", path, e.what());
+			}
+		});
+	}
+}
+
+void DynamicCubemaps::PostDeferred()
+{
 	ID3D11ShaderResourceView* views[2] = { (activeReflections ? envReflectionsTexture : envTexture)->srv.get(), envTexture->srv.get() };
-	context->PSSetShaderResources(30, 2, views);
+	ExtendedRendererState::GetSingleton()->SetPSResources(30, 2, views);
 }
 
 void DynamicCubemaps::SetupResources()
@@ -602,7 +1020,19 @@ void DynamicCubemaps::SetupResources()
 	}
 
 	{
-		spmapCB = new ConstantBuffer(ConstantBufferDesc<SpecularMapFilterSettingsCB>());
+		faceCB = new ConstantBuffer(ConstantBufferDesc<FaceCB>(), true);
+	}
+
+	{
+		singlePassMips = envTexture->desc.Width == 128 && envTexture->desc.Height == 128;
+		if (singlePassMips) {
+			GetComputeShaderMipChain();
+			CreateMipChainViews(envCaptureTexture, envCaptureMips);
+			CreateMipChainViews(envCaptureReflectionsTexture, envCaptureReflectionsMips);
+			CreateMipChainViews(envInferredTexture, envInferredMips);
+		} else {
+			logger::info("Cubemap faces are {}x{}, using GenerateMips for the mip chain", envTexture->desc.Width, envTexture->desc.Height);
+		}
 	}
 
 	{
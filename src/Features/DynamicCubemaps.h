@@ -4,6 +4,9 @@
 #include "Feature.h"
 #include "Util.h"
 
+#include <BS_thread_pool.hpp>
+#include <DirectXTex.h>
+
 class MenuOpenCloseEventHandler : public RE::BSTEventSink<RE::MenuOpenCloseEvent>
 {
 public:
@@ -26,14 +29,14 @@ public:
 
 	ID3D11SamplerState* computeSampler = nullptr;
 
-	struct alignas(16) SpecularMapFilterSettingsCB
+	struct alignas(16) FaceCB
 	{
-		float roughness;
-		float pad[3];
+		uint FaceOffset;
+		uint pad0[3];
 	};
 
 	ID3D11ComputeShader* specularIrradianceCS = nullptr;
-	ConstantBuffer* spmapCB = nullptr;
+	ConstantBuffer* faceCB = nullptr;
 	Texture2D* envTexture = nullptr;
 	Texture2D* envReflectionsTexture = nullptr;
 	ID3D11UnorderedAccessView* uavArray[7];
@@ -65,23 +68,36 @@ public:
 
 	Texture2D* envInferredTexture = nullptr;
 
+	// Single pass mip chain
+
+	struct MipChainViews
+	{
+		winrt::com_ptr<ID3D11ShaderResourceView> srv;  // mip 0 as a texture array
+		winrt::com_ptr<ID3D11UnorderedAccessView> uavs[7];
+	};
+
+	ID3D11ComputeShader* mipChainCS = nullptr;
+	bool singlePassMips = false;  // the downsampler is written for 128x128 faces
+
+	MipChainViews envCaptureMips;
+	MipChainViews envCaptureReflectionsMips;
+	MipChainViews envInferredMips;
+
 	ID3D11ShaderResourceView* defaultCubemap = nullptr;
 
 	bool activeReflections = false;
 	bool resetCapture[2] = { true, true };
 	bool recompileFlag = false;
+	float3 cameraPreviousPosAdjust[2] = { { 0, 0, 0 }, { 0, 0, 0 } };
+	uint capturesSinceReset[2] = { 0, 0 };
 
-	enum class NextTask
-	{
-		kCapture,
-		kInferrence,
-		kIrradiance,
-		kCapture2,
-		kInferrence2,
-		kIrradiance2
-	};
-
-	NextTask nextTask = NextTask::kCapture;
+	// Each cycle captures one cubemap, infers its faces over the next frames and then filters them.
+	// The filter samples the whole inferred cube, so it only starts once all six faces of this capture are in.
+	bool updatingReflections = false;
+	uint pendingFaces = 0;        // bitmask of faces still to infer in this cycle
+	uint pendingFilterFaces = 0;  // bitmask of faces still to filter in this cycle
+	uint qualityLevel = 0;
+	float3 previousEyePosition = { 0, 0, 0 };
 
 	// Editor window
 
@@ -89,12 +105,72 @@ public:
 	{
 		uint EnabledCreator = false;
 		uint EnabledSSR = true;
-		uint pad0[2];
+		uint FacesPerFrame = 1;
+		uint pad0;
 		float4 CubemapColor{ 1.0f, 1.0f, 1.0f, 0.0f };
 	};
 
 	Settings settings;
 	bool enabledAtBoot = false;
+
+	// Location cache
+
+	struct CacheSettings
+	{
+		uint LocationCacheSize = 8;  // converged cubemaps kept in VRAM, 0 disables the cache
+		bool SaveToDisk = false;     // also keep the filtered cubemap on disk as BC6H
+	};
+
+	CacheSettings cacheSettings;
+
+	struct LocationKey
+	{
+		RE::FormID formID = 0;  // interior cell or worldspace
+		int x = 0;              // position bucket
+		int y = 0;
+
+		bool operator==(const LocationKey&) const = default;
+	};
+
+	struct CachedLocation
+	{
+		LocationKey key;
+		uint lastUsed = 0;
+		bool hasReflections = false;
+		float3 cameraPreviousPosAdjust[2];
+		std::unique_ptr<Texture2D> textures[2][4];  // capture, raw capture, capture position and filtered cubemap
+	};
+
+	const std::string locationCachePath = "Data\\ShaderCache\\DynamicCubemaps";
+	static constexpr uint MIN_CACHED_CAPTURES = 32;  // captures before a cubemap is considered converged
+	static constexpr uint DISK_RESTORE_HOLD_CAPTURES = 8;
+	static constexpr float LOCATION_BUCKET_SIZE = 4096.0f;
+
+	std::vector<CachedLocation> locationCache;
+	uint locationCacheClock = 0;
+	uint holdFaceUpdates = 0;
+
+	// Set by the loading menu event, which is not sent on the render thread
+	std::mutex queuedLocationMutex;
+	std::optional<LocationKey> queuedStoreLocation;
+	std::optional<LocationKey> queuedRestoreLocation;
+	bool queuedResetCapture = false;
+
+	// Disk cache, readbacks are mapped once the GPU copy has finished and file I/O and BC6H run on a worker
+	winrt::com_ptr<ID3D11Texture2D> locationReadbackTexture;
+	std::optional<std::string> pendingSaveFile;
+	std::future<DirectX::ScratchImage> pendingLoad;
+	BS::thread_pool locationCacheWorker{ 1 };  // joined when the feature is destroyed
+
+	static bool GetCurrentLocation(LocationKey& a_key);
+	std::array<Texture2D*, 4> GetLocationTextures(bool a_reflections);
+	void StoreLocation(const LocationKey& a_key);
+	bool RestoreLocation(const LocationKey& a_key);
+	std::string GetLocationCacheFile(const LocationKey& a_key);
+	void TrimLocationCache();
+	void SaveLocationToDisk(const LocationKey& a_key);
+	bool LoadLocationFromDisk(const LocationKey& a_key);
+	void UpdateLocationDiskCache();
 	void UpdateCubemap();
 
 	void PostDeferred();
@@ -116,6 +192,10 @@ public:
 	virtual void DataLoaded() override;
 	virtual void PostPostLoad() override;
 
+	// Level 1 halves the faces per frame, level 2 also only updates on every other frame
+	virtual uint GetQualityLevelCount() override { return 3; }
+	virtual void SetQualityLevel(uint a_level) override { qualityLevel = a_level; }
+
 	std::map<std::string, Util::GameSetting> SSRSettings{
 		{ "fWaterSSRNormalPerturbationScale:Display", { "Water Normal Perturbation Scale", "Controls the scale of normal perturbations for Screen Space Reflections (SSR) on water surfaces.", 0, 0.05f, 0.f, 1.f } },
 		{ "fWaterSSRBlurAmount:Display", { "Water SSR Blur Amount", "Defines the amount of blur applied to Screen Space Reflections on water surfaces.", 0, 0.3f, 0.f, 1.f } },
@@ -143,12 +223,18 @@ public:
 	ID3D11ComputeShader* GetComputeShaderInferrence();
 	ID3D11ComputeShader* GetComputeShaderInferrenceReflections();
 	ID3D11ComputeShader* GetComputeShaderSpecularIrradiance();
+	ID3D11ComputeShader* GetComputeShaderMipChain();
 
 	void UpdateCubemapCapture(bool a_reflections);
 
-	void Inferrence(bool a_reflections);
+	void Inferrence(bool a_reflections, uint a_face);
+
+	void Irradiance(bool a_reflections, uint a_face);
+
+	void CreateMipChainViews(Texture2D* a_texture, MipChainViews& a_views);
+	void GenerateMipChain(Texture2D* a_texture, MipChainViews& a_views, uint a_firstFace, uint a_faceCount);
 
-	void Irradiance(bool a_reflections);
+	uint GetNextFace(uint a_pendingFaces, const float3& a_motion);
 
 	virtual bool SupportsVR() override { return true; };
 	virtual bool IsCore() const override { return true; };
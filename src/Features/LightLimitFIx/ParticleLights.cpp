@@ -29,7 +29,7 @@ void ParticleLights::GetConfigs()
 			}
 
 			Config data{};
-			particleLightConfigs.insert({ "default", data });
+			particleLightConfigs.insert({ HashStem("default"), data });
 
 			data.cull = ini.GetBoolValue("Light", "Cull", false);
 			data.colorMult.red = (float)ini.GetDoubleValue("Light", "ColorMultRed", 1.0);
@@ -51,7 +51,7 @@ void ParticleLights::GetConfigs()
 
 				logger::debug("[LLF] Inserting {}", filename);
 
-				particleLightConfigs.insert({ filename, data });
+				particleLightConfigs.insert({ HashStem(filename), data });
 			} else {
 				logger::error("[LLF] Path incomplete");
 			}
@@ -127,7 +127,7 @@ void ParticleLights::GetConfigs()
 
 				logger::debug("[LLF] Inserting {}", filename);
 
-				particleLightGradientConfigs.insert({ filename, data });
+				particleLightGradientConfigs.insert({ HashStem(filename), data });
 			} else {
 				logger::error("[LLF] Path incomplete");
 			}
@@ -22,8 +22,213 @@ public:
 		RE::NiColor color;
 	};
 
-	ankerl::unordered_dense::map<std::string, Config> particleLightConfigs;
-	ankerl::unordered_dense::map<std::string, GradientConfig> particleLightGradientConfigs;
+	// Keyed by HashStem of the lowercase texture file name
+	ankerl::unordered_dense::map<std::uint64_t, Config> particleLightConfigs;
+	ankerl::unordered_dense::map<std::uint64_t, GradientConfig> particleLightGradientConfigs;
 
 	void GetConfigs();
+
+	/**
+	 * Case-insensitive FNV-1a hash of a texture stem, computed without allocating.
+	 *
+	 * \return 0 if the stem is empty
+	 */
+	static constexpr std::uint64_t HashStem(std::string_view a_stem)
+	{
+		if (a_stem.empty())
+			return 0;
+
+		std::uint64_t hash = 0xcbf29ce484222325ull;
+		for (char c : a_stem) {
+			if (c >= 'A' && c <= 'Z')
+				c += 'a' - 'A';
+			hash ^= static_cast<std::uint8_t>(c);
+			hash *= 0x100000001b3ull;
+		}
+		return hash;
+	}
+
+	/**
+	 * Hashes the file name of a texture path without its directory and ".dds" extension.
+	 *
+	 * \return 0 if the path has no file name
+	 */
+	static constexpr std::uint64_t HashTextureStem(std::string_view a_path)
+	{
+		auto lastSeparatorPos = a_path.find_last_of("\\/");
+		if (lastSeparatorPos == std::string_view::npos)
+			return 0;
+
+		a_path = a_path.substr(lastSeparatorPos + 1);
+		if (a_path.size() <= 4)
+			return 0;
+
+		a_path.remove_suffix(4);  // Remove ".dds"
+		return HashStem(a_path);
+	}
+
+	/**
+	 * Bounded open-addressed cache keyed by geometry pointer.
+	 * Below MaxCapacity a full table is rebuilt without entries which have not been looked up for EvictionAge generations,
+	 * growing if that does not free enough space. At MaxCapacity a full table drops one entry per insert with clock eviction,
+	 * so it cannot grow unboundedly over long sessions and a miss never rescans the table.
+	 */
+	template <class T>
+	class GeometryCache
+	{
+	public:
+		static constexpr std::uint32_t InitialCapacity = 1024;
+		static constexpr std::uint32_t MaxCapacity = 16384;
+		static constexpr std::uint32_t EvictionAge = 600;
+
+		T* Find(const void* a_key, std::uint32_t a_generation)
+		{
+			if (entries.empty())
+				return nullptr;
+
+			for (std::uint32_t i = Hash(a_key) & mask; entries[i].key; i = (i + 1) & mask) {
+				if (entries[i].key == a_key) {
+					entries[i].generation = a_generation;
+					entries[i].referenced = true;
+					return &entries[i].value;
+				}
+			}
+			return nullptr;
+		}
+
+		void Insert(const void* a_key, const T& a_value, std::uint32_t a_generation)
+		{
+			if (entries.empty())
+				Rebuild(InitialCapacity, a_generation);
+			else if ((count + 1) * 4 > capacity * 3 && !Find(a_key, a_generation)) {
+				if (capacity < MaxCapacity)
+					Evict(a_generation);
+				else
+					EvictOne();
+			}
+
+			std::uint32_t i = Hash(a_key) & mask;
+			while (entries[i].key && entries[i].key != a_key)
+				i = (i + 1) & mask;
+
+			if (!entries[i].key)
+				count++;
+			entries[i] = { a_key, a_generation, true, a_value };
+		}
+
+		void Erase(const void* a_key)
+		{
+			if (entries.empty())
+				return;
+
+			std::uint32_t i = Hash(a_key) & mask;
+			while (entries[i].key != a_key) {
+				if (!entries[i].key)
+					return;
+				i = (i + 1) & mask;
+			}
+
+			EraseAt(i);
+		}
+
+		void Clear()
+		{
+			entries.clear();
+			capacity = mask = count = hand = 0;
+		}
+
+		std::uint32_t Size() const { return count; }
+
+	private:
+		struct Entry
+		{
+			const void* key = nullptr;
+			std::uint32_t generation = 0;
+			bool referenced = false;  // looked up since the clock hand last passed
+			T value{};
+		};
+
+		static std::uint32_t Hash(const void* a_key)
+		{
+			auto k = reinterpret_cast<std::uintptr_t>(a_key);
+			k ^= k >> 33;
+			k *= 0xff51afd7ed558ccdull;
+			k ^= k >> 33;
+			return static_cast<std::uint32_t>(k);
+		}
+
+		void EraseAt(std::uint32_t i)
+		{
+			// Backward shift deletion keeps probe sequences intact without tombstones
+			entries[i] = {};
+			for (std::uint32_t j = (i + 1) & mask; entries[j].key; j = (j + 1) & mask) {
+				std::uint32_t home = Hash(entries[j].key) & mask;
+				if (i <= j ? (i < home && home <= j) : (i < home || home <= j))
+					continue;
+				entries[i] = entries[j];
+				entries[j] = {};
+				i = j;
+			}
+			count--;
+		}
+
+		// Clock eviction, entries looked up since the hand last passed get a second chance
+		void EvictOne()
+		{
+			for (;; hand = (hand + 1) & mask) {
+				auto& entry = entries[hand];
+				if (!entry.key)
+					continue;
+				if (entry.referenced) {
+					entry.referenced = false;
+					continue;
+				}
+				EraseAt(hand);
+				return;
+			}
+		}
+
+		void Evict(std::uint32_t a_generation)
+		{
+			std::uint32_t alive = 0;
+			for (const auto& entry : entries)
+				if (entry.key && a_generation - entry.generation <= EvictionAge)
+					alive++;
+
+			// Only grow if dropping stale entries does not free enough space, the survivors always fit at half load
+			std::uint32_t newCapacity = capacity;
+			while ((alive + 1) * 2 > newCapacity)
+				newCapacity *= 2;
+
+			Rebuild(newCapacity, a_generation);
+		}
+
+		void Rebuild(std::uint32_t a_capacity, std::uint32_t a_generation)
+		{
+			auto oldEntries = std::move(entries);
+
+			entries.assign(a_capacity, {});
+			capacity = a_capacity;
+			mask = a_capacity - 1;
+			count = 0;
+			hand = 0;
+
+			for (const auto& entry : oldEntries) {
+				if (!entry.key || a_generation - entry.generation > EvictionAge)
+					continue;
+
+				std::uint32_t i = Hash(entry.key) & mask;
+				while (entries[i].key)
+					i = (i + 1) & mask;
+				entries[i] = entry;
+				count++;
+			}
+		}
+
+		std::vector<Entry> entries;
+		std::uint32_t capacity = 0;
+		std::uint32_t mask = 0;
+		std::uint32_t count = 0;
+		std::uint32_t hand = 0;  // clock position for EvictOne
+	};
 };
\ No newline at end of file
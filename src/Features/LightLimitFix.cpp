@@ -1,5 +1,6 @@
 #include "LightLimitFix.h"
 
+#include "ExtendedRendererState.h"
 #include "Shadercache.h"
 #include "State.h"
 #include "Util.h"
@@ -7,6 +8,23 @@
 
 static constexpr uint CLUSTER_MAX_LIGHTS = 256;
 static constexpr uint MAX_LIGHTS = 1024;
+static constexpr uint MAX_DIRTY_LIGHTS = 128;
+static constexpr uint MAX_INCREMENTAL_CULLING_FRAMES = 16;
+static constexpr uint CLUSTER_TILE_SIZES[] = { 32, 64, 128, 256 };
+
+// The light index list starts at its full size and is shrunk from the statistics readback, never below this many lights per cluster
+static constexpr uint MIN_CLUSTER_LIGHTS = 8;
+static constexpr uint LOW_OCCUPANCY_READBACKS = 600;
+
+// Layout of the statistics buffer, must match LightLimitFix/Common.hlsli
+static constexpr uint STATS_MAX_LIGHTS = 0;
+static constexpr uint STATS_TOTAL_LIGHTS = 1;
+static constexpr uint STATS_OVERFLOW_CLUSTERS = 2;
+static constexpr uint STATS_TRUNCATED_CLUSTERS = 3;
+static constexpr uint STATS_INDEX_COUNT = 4;
+static constexpr uint STATS_HISTOGRAM = 5;
+static constexpr uint STATS_SIZE = 16;
+static_assert(STATS_HISTOGRAM + LightLimitFix::STATISTICS_HISTOGRAM_BINS <= STATS_SIZE);
 
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(
 	LightLimitFix::Settings,
@@ -19,7 +37,12 @@ NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(
 	ParticleBrightness,
 	ParticleRadius,
 	BillboardBrightness,
-	BillboardRadius)
+	BillboardRadius,
+	ClusterTileSize,
+	ClusterSlices,
+	EnableNearBiasedSlices,
+	ClusterFarCutoff,
+	EnableClusterCullingCache)
 
 void LightLimitFix::DrawSettings()
 {
@@ -73,6 +96,49 @@ void LightLimitFix::DrawSettings()
 		ImGui::TreePop();
 	}
 
+	if (ImGui::TreeNodeEx("Clusters", ImGuiTreeNodeFlags_DefaultOpen)) {
+		{
+			static const char* tileSizeOptions[] = { "32 px", "64 px", "128 px", "256 px" };
+			static_assert(ARRAYSIZE(tileSizeOptions) == ARRAYSIZE(CLUSTER_TILE_SIZES));
+			int tileSizeIndex = (int)(std::ranges::find(CLUSTER_TILE_SIZES, settings.ClusterTileSize) - std::begin(CLUSTER_TILE_SIZES));
+			if (ImGui::Combo("Tile Size", &tileSizeIndex, tileSizeOptions, ARRAYSIZE(tileSizeOptions))) {
+				settings.ClusterTileSize = CLUSTER_TILE_SIZES[std::clamp(tileSizeIndex, 0, (int)ARRAYSIZE(CLUSTER_TILE_SIZES) - 1)];
+				clusterResourcesDirty = true;
+			}
+			if (auto _tt = Util::HoverTooltipWrapper()) {
+				ImGui::Text("Screen-space size of a cluster. Smaller tiles cull more precisely but cost more to build and cull.");
+			}
+		}
+
+		clusterResourcesDirty |= ImGui::SliderInt("Depth Slices", (int*)&settings.ClusterSlices, 4, 64);
+		if (auto _tt = Util::HoverTooltipWrapper()) {
+			ImGui::Text("Number of depth slices the view frustum is split into.");
+		}
+
+		clusterBuildingDirty |= ImGui::Checkbox("Near-Biased Slices", &settings.EnableNearBiasedSlices);
+		if (auto _tt = Util::HoverTooltipWrapper()) {
+			ImGui::Text("Distributes slices up to the far cutoff only, everything beyond it shares a single slice.");
+		}
+
+		{
+			auto _ = Util::DisableGuard(!settings.EnableNearBiasedSlices);
+			clusterBuildingDirty |= ImGui::SliderFloat("Far Cutoff", &settings.ClusterFarCutoff, 1024.0f, 32768.0f, "%.0f game units");
+		}
+
+		ImGui::Checkbox("Cache Culling", &settings.EnableClusterCullingCache);
+		if (auto _tt = Util::HoverTooltipWrapper()) {
+			ImGui::Text("Reuses the previous culling result when the view and lights are unchanged, and only re-culls clusters touched by moving lights.");
+		}
+
+		ImGui::Text(std::format("Grid : {} x {} x {} ({} clusters)", clusterSize[0], clusterSize[1], clusterSize[2], clusterSize[0] * clusterSize[1] * clusterSize[2]).c_str());
+		ImGui::Text(std::format("Culling Cost : {:.3f} ms", clusterCullingTimer.GetTime()).c_str());
+		ImGui::Text(std::format("Culling Mode : {}", magic_enum::enum_name(cullingMode)).c_str());
+
+		ImGui::Spacing();
+		ImGui::Spacing();
+		ImGui::TreePop();
+	}
+
 	auto& shaderCache = SIE::ShaderCache::Instance();
 
 	if (ImGui::TreeNodeEx("Light Limit Visualization", ImGuiTreeNodeFlags_DefaultOpen)) {
@@ -108,6 +174,35 @@ void LightLimitFix::DrawSettings()
 		ImGui::Text(std::format("Clustered Light Count : {}", lightCount).c_str());
 		ImGui::Text(std::format("Particle Lights Count : {}", currentParticleLights.size()).c_str());
 
+		ImGui::Spacing();
+		ImGui::Text(std::format("Max Lights Per Cluster : {}", clusterStatistics.maxLights).c_str());
+		ImGui::Text(std::format("Mean Lights Per Cluster : {:.3f}", clusterStatistics.meanLights).c_str());
+		ImGui::Text(std::format("Overflowing Clusters : {}", clusterStatistics.overflowClusters).c_str());
+		if (auto _tt = Util::HoverTooltipWrapper()) {
+			ImGui::Text("Clusters touched by more than %u lights. Extra lights are dropped.", CLUSTER_MAX_LIGHTS);
+		}
+		ImGui::Text(std::format("Truncated Clusters : {}", clusterStatistics.truncatedClusters).c_str());
+		if (auto _tt = Util::HoverTooltipWrapper()) {
+			ImGui::Text("Clusters which did not fit in the light index list. It is grown automatically.");
+		}
+		ImGui::Text(std::format("Light Index List : {} / {} ({:.2f} MB)", clusterStatistics.usedIndices, lightIndexCapacity, (lightIndexCapacity * sizeof(uint32_t)) / (1024.0f * 1024.0f)).c_str());
+
+		{
+			static const char* binLabels[STATISTICS_HISTOGRAM_BINS] = { "0", "1", "2-3", "4-7", "8-15", "16-31", "32-63", "64-127", "128-255", "256" };
+			if (ImGui::BeginTable("Lights Per Cluster", 2, ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit)) {
+				ImGui::TableSetupColumn("Lights");
+				ImGui::TableSetupColumn("Clusters");
+				ImGui::TableHeadersRow();
+				for (uint i = 0; i < STATISTICS_HISTOGRAM_BINS; i++) {
+					ImGui::TableNextColumn();
+					ImGui::Text(binLabels[i]);
+					ImGui::TableNextColumn();
+					ImGui::Text(std::format("{}", clusterStatistics.histogram[i]).c_str());
+				}
+				ImGui::EndTable();
+			}
+		}
+
 		ImGui::TreePop();
 	}
 }
@@ -119,24 +214,74 @@ LightLimitFix::PerFrame LightLimitFix::GetCommonBufferData()
 	perFrame.EnableLightsVisualisation = settings.EnableLightsVisualisation;
 	perFrame.LightsVisualisationMode = settings.LightsVisualisationMode;
 	std::copy(clusterSize, clusterSize + 3, perFrame.ClusterSize);
+
+	perFrame.ClusterNear = clusterNear;
+	perFrame.ClusterFar = clusterFar;
+	GetClusterSlicing(clusterNear, clusterFar, perFrame.ClusterFarCutoff, perFrame.ClusterSize[3]);
 	return perFrame;
 }
 
 void LightLimitFix::CleanupParticleLights(RE::NiNode* a_node)
 {
-	particleLightsReferences.erase(a_node);
+	particleLightsReferences.Erase(a_node);
 }
 
 void LightLimitFix::SetupResources()
 {
+	SetupClusterResources();
+
+	lightBuildingCB = new ConstantBuffer(ConstantBufferDesc<LightBuildingCB>(), true);
+	lightCullingCB = new ConstantBuffer(ConstantBufferDesc<LightCullingCB>(), true);
+
+	{
+		D3D11_BUFFER_DESC sbDesc{};
+		sbDesc.Usage = D3D11_USAGE_DYNAMIC;
+		sbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		sbDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		sbDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+		sbDesc.StructureByteStride = sizeof(LightData);
+		sbDesc.ByteWidth = sizeof(LightData) * MAX_LIGHTS;
+		lights = eastl::make_unique<Buffer>(sbDesc);
+
+		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
+		srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+		srvDesc.Buffer.FirstElement = 0;
+		srvDesc.Buffer.NumElements = MAX_LIGHTS;
+		lights->CreateSRV(srvDesc);
+
+		sbDesc.StructureByteStride = sizeof(DirtyLight);
+		sbDesc.ByteWidth = sizeof(DirtyLight) * MAX_DIRTY_LIGHTS;
+		dirtyLights = eastl::make_unique<Buffer>(sbDesc);
+
+		srvDesc.Buffer.NumElements = MAX_DIRTY_LIGHTS;
+		dirtyLights->CreateSRV(srvDesc);
+	}
+
+	{
+		strictLightDataCB = new ConstantBuffer(ConstantBufferDesc<StrictLightDataCB>(), true);
+	}
+}
+
+void LightLimitFix::SetupClusterResources()
+{
+	// Snap to the closest size the menu offers, so a hand-edited value still shows up in the combo
+	settings.ClusterTileSize = *std::ranges::min_element(CLUSTER_TILE_SIZES, {}, [&](uint a_size) { return std::abs((int)a_size - (int)settings.ClusterTileSize); });
+	settings.ClusterSlices = std::clamp(settings.ClusterSlices, 4u, 64u);
+
 	auto screenSize = Util::ConvertToDynamic(State::GetSingleton()->screenSize);
 	if (REL::Module::IsVR())
 		screenSize.x *= .5;
-	clusterSize[0] = ((uint)screenSize.x + 63) / 64;
-	clusterSize[1] = ((uint)screenSize.y + 63) / 64;
-	clusterSize[2] = 32;
+	clusterSize[0] = ((uint)screenSize.x + settings.ClusterTileSize - 1) / settings.ClusterTileSize;
+	clusterSize[1] = ((uint)screenSize.y + settings.ClusterTileSize - 1) / settings.ClusterTileSize;
+	clusterSize[2] = settings.ClusterSlices;
 	uint clusterCount = clusterSize[0] * clusterSize[1] * clusterSize[2];
 
+	if (clusterBuildingCS)
+		clusterBuildingCS->Release();
+	if (clusterCullingCS)
+		clusterCullingCS->Release();
+
 	{
 		std::string clusterSizeStrs[3];
 		for (int i = 0; i < 3; ++i)
@@ -150,9 +295,6 @@ void LightLimitFix::SetupResources()
 
 		clusterBuildingCS = (ID3D11ComputeShader*)Util::CompileShader(L"Data\\Shaders\\LightLimitFix\\ClusterBuildingCS.hlsl", defines, "cs_5_0");
 		clusterCullingCS = (ID3D11ComputeShader*)Util::CompileShader(L"Data\\Shaders\\LightLimitFix\\ClusterCullingCS.hlsl", defines, "cs_5_0");
-
-		lightBuildingCB = new ConstantBuffer(ConstantBufferDesc<LightBuildingCB>());
-		lightCullingCB = new ConstantBuffer(ConstantBufferDesc<LightCullingCB>());
 	}
 
 	{
@@ -192,14 +334,12 @@ void LightLimitFix::SetupResources()
 		uavDesc.Buffer.NumElements = numElements;
 		lightIndexCounter->CreateUAV(uavDesc);
 
-		numElements = clusterCount * CLUSTER_MAX_LIGHTS;
+		numElements = STATS_SIZE;
 		sbDesc.StructureByteStride = sizeof(uint32_t);
 		sbDesc.ByteWidth = sizeof(uint32_t) * numElements;
-		lightIndexList = eastl::make_unique<Buffer>(sbDesc);
-		srvDesc.Buffer.NumElements = numElements;
-		lightIndexList->CreateSRV(srvDesc);
+		statistics = eastl::make_unique<Buffer>(sbDesc);
 		uavDesc.Buffer.NumElements = numElements;
-		lightIndexList->CreateUAV(uavDesc);
+		statistics->CreateUAV(uavDesc);
 
 		numElements = clusterCount;
 		sbDesc.StructureByteStride = sizeof(LightGrid);
@@ -212,26 +352,60 @@ void LightLimitFix::SetupResources()
 	}
 
 	{
-		D3D11_BUFFER_DESC sbDesc{};
-		sbDesc.Usage = D3D11_USAGE_DYNAMIC;
-		sbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-		sbDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-		sbDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
-		sbDesc.StructureByteStride = sizeof(LightData);
-		sbDesc.ByteWidth = sizeof(LightData) * MAX_LIGHTS;
-		lights = eastl::make_unique<Buffer>(sbDesc);
-
-		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
-		srvDesc.Format = DXGI_FORMAT_UNKNOWN;
-		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
-		srvDesc.Buffer.FirstElement = 0;
-		srvDesc.Buffer.NumElements = MAX_LIGHTS;
-		lights->CreateSRV(srvDesc);
+		D3D11_BUFFER_DESC stagingDesc = statistics->desc;
+		stagingDesc.Usage = D3D11_USAGE_STAGING;
+		stagingDesc.BindFlags = 0;
+		stagingDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+
+		auto device = State::GetSingleton()->device;
+		for (auto& readback : statisticsReadbacks) {
+			readback = {};
+			DX::ThrowIfFailed(device->CreateBuffer(&stagingDesc, nullptr, readback.staging.put()));
+		}
+		statisticsReadbackIndex = 0;
+		clusterStatistics = {};
+		lowOccupancyReadbacks = 0;
 	}
 
-	{
-		strictLightDataCB = new ConstantBuffer(ConstantBufferDesc<StrictLightDataCB>());
-	}
+	CreateLightIndexList(clusterCount * CLUSTER_MAX_LIGHTS);
+
+	clusterResourcesDirty = false;
+	clusterBuildingDirty = true;
+}
+
+void LightLimitFix::CreateLightIndexList(uint a_capacity)
+{
+	uint clusterCount = clusterSize[0] * clusterSize[1] * clusterSize[2];
+	lightIndexCapacity = std::clamp(a_capacity, clusterCount, clusterCount * CLUSTER_MAX_LIGHTS);
+
+	D3D11_BUFFER_DESC sbDesc{};
+	sbDesc.Usage = D3D11_USAGE_DEFAULT;
+	sbDesc.CPUAccessFlags = 0;
+	sbDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
+	sbDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+	sbDesc.StructureByteStride = sizeof(uint32_t);
+	sbDesc.ByteWidth = sizeof(uint32_t) * lightIndexCapacity;
+	lightIndexList = eastl::make_unique<Buffer>(sbDesc);
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc{};
+	srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+	srvDesc.Buffer.FirstElement = 0;
+	srvDesc.Buffer.NumElements = lightIndexCapacity;
+	lightIndexList->CreateSRV(srvDesc);
+
+	D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc{};
+	uavDesc.Format = DXGI_FORMAT_UNKNOWN;
+	uavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+	uavDesc.Buffer.FirstElement = 0;
+	uavDesc.Buffer.Flags = 0;
+	uavDesc.Buffer.NumElements = lightIndexCapacity;
+	lightIndexList->CreateUAV(uavDesc);
+
+	// Previous results point into the old list, and statistics in flight describe it
+	forceFullCulling = true;
+	for (auto& readback : statisticsReadbacks)
+		readback.pending = false;
 }
 
 void LightLimitFix::Reset()
@@ -361,17 +535,17 @@ void LightLimitFix::BSLightingShader_SetupGeometry_After(RE::BSRenderPass*)
 	const bool isWorld = accumulator->GetRuntimeData().activeShadowSceneNode == shadowSceneNode;
 	const int roomIndex = strictLightDataTemp.RoomIndex;
 
+	bool bindStrictLightData = frameChecker.IsNewFrame();
 	if (!isEmpty || (isEmpty && !wasEmpty) || isWorld != wasWorld || previousRoomIndex != roomIndex) {
 		strictLightDataCB->Update(strictLightDataTemp);
 		wasEmpty = isEmpty;
 		wasWorld = isWorld;
 		previousRoomIndex = roomIndex;
+		bindStrictLightData = true;
 	}
 
-	if (frameChecker.IsNewFrame()) {
-		ID3D11Buffer* buffer = { strictLightDataCB->CB() };
-		context->PSSetConstantBuffers(3, 1, &buffer);
-	}
+	if (bindStrictLightData)
+		strictLightDataCB->PSSet(context, 3);
 }
 
 void LightLimitFix::SetLightPosition(LightLimitFix::LightData& a_light, RE::NiPoint3 a_initialPosition, bool a_cached)
@@ -432,8 +606,8 @@ void LightLimitFix::AddParticleLightLuminance(RE::NiPoint3& targetPosition, int&
 
 void LightLimitFix::Prepass()
 {
-	auto variableCache = VariableCache::GetSingleton();
-	auto context = variableCache->context;
+	if (clusterResourcesDirty)
+		SetupClusterResources();
 
 	UpdateLights();
 
@@ -441,7 +615,7 @@ void LightLimitFix::Prepass()
 	views[0] = lights->srv.get();
 	views[1] = lightIndexList->srv.get();
 	views[2] = lightGrid->srv.get();
-	context->PSSetShaderResources(35, ARRAYSIZE(views), views);
+	ExtendedRendererState::GetSingleton()->SetPSResources(35, ARRAYSIZE(views), views);
 }
 
 bool LightLimitFix::IsValidLight(RE::BSLight* a_light)
@@ -464,31 +638,13 @@ struct VertexPosition
 	std::uint8_t data[3];
 };
 
-std::string ExtractTextureStem(std::string_view a_path)
-{
-	if (a_path.size() < 1)
-		return {};
-
-	auto lastSeparatorPos = a_path.find_last_of("\\/");
-	if (lastSeparatorPos == std::string::npos)
-		return {};
-
-	a_path = a_path.substr(lastSeparatorPos + 1);
-	a_path.remove_suffix(4);  // Remove ".dds"
-
-	auto textureNameView = a_path | std::views::transform([](auto c) { return (char)::tolower(c); });
-	std::string textureName = { textureNameView.begin(), textureNameView.end() };
-
-	return textureName;
-}
-
 LightLimitFix::ParticleLightReference LightLimitFix::GetParticleLightConfigs(RE::BSRenderPass* a_pass)
 {
 	auto variableCache = VariableCache::GetSingleton();
 	auto particleLights = variableCache->particleLights;
 
 	// see https://www.nexusmods.com/skyrimspecialedition/articles/1391
-	if (settings.EnableParticleLights) {
+	if (settings.EnableParticleLights && !qualityLevel) {
 		if (auto shaderProperty = netimmerse_cast<RE::BSEffectShaderProperty*>(a_pass->shaderProperty)) {
 			if (!shaderProperty->lightData) {
 				if (auto material = shaderProperty->GetMaterial()) {
@@ -507,41 +663,39 @@ LightLimitFix::ParticleLightReference LightLimitFix::GetParticleLightConfigs(RE:
 					}
 
 					// Already scanned
-					{
-						auto it = particleLightsReferences.find(reinterpret_cast<RE::NiNode*>(a_pass->geometry));
-						if (it != particleLightsReferences.end())
-							return (*it).second;
-					}
+					auto frameCount = RE::BSGraphics::State::GetSingleton()->frameCount;
+					if (auto cached = particleLightsReferences.Find(a_pass->geometry, frameCount))
+						return *cached;
 
 					// Not scanned, scan now
 
 					if (!material->sourceTexturePath.empty()) {
-						std::string textureName = ExtractTextureStem(material->sourceTexturePath.c_str());
-						if (textureName.size() < 1) {
-							particleLightsReferences.insert({ (RE::NiNode*)a_pass->geometry, { false } });
+						auto textureHash = ParticleLights::HashTextureStem(material->sourceTexturePath.c_str());
+						if (!textureHash) {
+							particleLightsReferences.Insert(a_pass->geometry, { false }, frameCount);
 							return { false };
 						}
 
 						auto& configs = particleLights->particleLightConfigs;
-						auto it = configs.find(textureName);
+						auto it = configs.find(textureHash);
 						if (it == configs.end()) {
-							particleLightsReferences.insert({ (RE::NiNode*)a_pass->geometry, { false } });
+							particleLightsReferences.Insert(a_pass->geometry, { false }, frameCount);
 							return { false };
 						}
 
 						ParticleLights::Config* config = &it->second;
 						ParticleLights::GradientConfig* gradientConfig = nullptr;
 						if (!material->greyscaleTexturePath.empty()) {
-							textureName = ExtractTextureStem(material->greyscaleTexturePath.c_str());
-							if (textureName.size() < 1) {
-								particleLightsReferences.insert({ (RE::NiNode*)a_pass->geometry, { false } });
+							textureHash = ParticleLights::HashTextureStem(material->greyscaleTexturePath.c_str());
+							if (!textureHash) {
+								particleLightsReferences.Insert(a_pass->geometry, { false }, frameCount);
 								return { false };
 							}
 
 							auto& gradientConfigs = particleLights->particleLightGradientConfigs;
-							auto itGradient = gradientConfigs.find(textureName);
+							auto itGradient = gradientConfigs.find(textureHash);
 							if (itGradient == gradientConfigs.end()) {
-								particleLightsReferences.insert({ (RE::NiNode*)a_pass->geometry, { false } });
+								particleLightsReferences.Insert(a_pass->geometry, { false }, frameCount);
 								return { false };
 							}
 							gradientConfig = &itGradient->second;
@@ -586,7 +740,7 @@ LightLimitFix::ParticleLightReference LightLimitFix::GetParticleLightConfigs(RE:
 							}
 						}
 
-						particleLightsReferences.insert({ reinterpret_cast<RE::NiNode*>(a_pass->geometry), reference });
+						particleLightsReferences.Insert(a_pass->geometry, reference, frameCount);
 						return reference;
 					}
 				}
@@ -677,6 +831,147 @@ void LightLimitFix::DataLoaded()
 	logger::info("[LLF] Unlocked magic light limit");
 }
 
+void LightLimitFix::GetClusterSlicing(float a_near, float a_far, float& a_farCutoff, uint& a_logSlices)
+{
+	a_farCutoff = a_far;
+	a_logSlices = clusterSize[2];
+
+	// Reserve the last slice for everything beyond the cutoff
+	if (settings.EnableNearBiasedSlices && clusterSize[2] > 1 && settings.ClusterFarCutoff > a_near && settings.ClusterFarCutoff < a_far) {
+		a_farCutoff = settings.ClusterFarCutoff;
+		a_logSlices = clusterSize[2] - 1;
+	}
+}
+
+LightLimitFix::CullingMode LightLimitFix::UpdateCullingCache(const eastl::vector<LightData>& a_lightsData, bool a_clustersRebuilt, bool& a_lightsChanged)
+{
+	dirtyLightsData.clear();
+
+	auto lightsHash = ankerl::unordered_dense::detail::wyhash::hash(a_lightsData.data(), sizeof(LightData) * a_lightsData.size());
+	bool viewChanged = memcmp(previousViewMatrix, viewMatrixCached, sizeof(Matrix) * eyeCount) != 0;
+
+	a_lightsChanged = lightsHash != previousLightsHash || a_lightsData.size() != previousLightsData.size();
+
+	CullingMode mode = CullingMode::Full;
+	if (settings.EnableClusterCullingCache && !a_clustersRebuilt && !forceFullCulling && !viewChanged && a_lightsData.size() == previousLightsData.size()) {
+		mode = CullingMode::Reused;
+
+		if (a_lightsChanged) {
+			for (size_t i = 0; i < a_lightsData.size(); i++) {
+				const auto& current = a_lightsData[i];
+				const auto& previous = previousLightsData[i];
+
+				// Colour changes do not affect which clusters a light touches
+				if (current.radius == previous.radius && memcmp(current.positionVS, previous.positionVS, sizeof(current.positionVS)) == 0)
+					continue;
+
+				if (dirtyLightsData.size() + 2 > MAX_DIRTY_LIGHTS || incrementalCullingFrames >= MAX_INCREMENTAL_CULLING_FRAMES) {
+					mode = CullingMode::Full;
+					break;
+				}
+
+				// Clusters around both the old and the new position need to be re-culled
+				for (const auto* light : { &previous, &current }) {
+					DirtyLight dirtyLight{};
+					for (int eyeIndex = 0; eyeIndex < 2; eyeIndex++)
+						dirtyLight.positionVS[eyeIndex] = { light->positionVS[eyeIndex].data.x, light->positionVS[eyeIndex].data.y, light->positionVS[eyeIndex].data.z, light->radius };
+					dirtyLightsData.push_back(dirtyLight);
+				}
+				mode = CullingMode::Incremental;
+			}
+		}
+	}
+
+	if (mode == CullingMode::Full) {
+		dirtyLightsData.clear();
+		incrementalCullingFrames = 0;
+		forceFullCulling = false;
+	} else if (mode == CullingMode::Incremental) {
+		incrementalCullingFrames++;
+	}
+
+	std::copy(viewMatrixCached, viewMatrixCached + 2, previousViewMatrix);
+	previousLightsHash = lightsHash;
+	previousLightsData = a_lightsData;
+
+	return mode;
+}
+
+void LightLimitFix::QueueClusterStatistics(ID3D11DeviceContext* a_context, bool a_full)
+{
+	auto& readback = statisticsReadbacks[statisticsReadbackIndex];
+	if (readback.pending)
+		return;
+
+	a_context->CopyResource(readback.staging.get(), statistics->resource.get());
+
+	D3D11_BOX box{ 0, 0, 0, sizeof(uint32_t), 1, 1 };
+	a_context->CopySubresourceRegion(readback.staging.get(), 0, STATS_INDEX_COUNT * sizeof(uint32_t), 0, 0, lightIndexCounter->resource.get(), 0, &box);
+
+	readback.pending = true;
+	readback.full = a_full;
+	statisticsReadbackIndex = (statisticsReadbackIndex + 1) % STATISTICS_LATENCY;
+}
+
+void LightLimitFix::ReadbackClusterStatistics(ID3D11DeviceContext* a_context)
+{
+	auto& readback = statisticsReadbacks[statisticsReadbackIndex];
+	if (!readback.pending)
+		return;
+
+	// Never stall, try again next frame if the copy has not landed yet
+	D3D11_MAPPED_SUBRESOURCE mapped;
+	if (a_context->Map(readback.staging.get(), 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped) != S_OK)
+		return;
+
+	uint data[STATS_SIZE];
+	memcpy(data, mapped.pData, sizeof(data));
+	a_context->Unmap(readback.staging.get(), 0);
+	readback.pending = false;
+
+	UpdateClusterStatistics(data, readback.full);
+}
+
+void LightLimitFix::UpdateClusterStatistics(const uint* a_data, bool a_full)
+{
+	uint clusterCount = clusterSize[0] * clusterSize[1] * clusterSize[2];
+
+	clusterStatistics.usedIndices = a_data[STATS_INDEX_COUNT];
+	clusterStatistics.truncatedClusters = a_data[STATS_TRUNCATED_CLUSTERS];
+
+	// Incremental culls only see the clusters they touched
+	if (a_full) {
+		clusterStatistics.maxLights = a_data[STATS_MAX_LIGHTS];
+		clusterStatistics.meanLights = (float)a_data[STATS_TOTAL_LIGHTS] / (float)clusterCount;
+		clusterStatistics.overflowClusters = a_data[STATS_OVERFLOW_CLUSTERS];
+		std::copy(a_data + STATS_HISTOGRAM, a_data + STATS_HISTOGRAM + STATISTICS_HISTOGRAM_BINS, clusterStatistics.histogram);
+	}
+
+	// Size the light index list from the observed occupancy with 2x headroom
+	uint requiredIndices = std::max(a_data[STATS_INDEX_COUNT], a_full ? a_data[STATS_TOTAL_LIGHTS] : 0);
+	if (clusterStatistics.truncatedClusters)
+		requiredIndices = std::max(requiredIndices, lightIndexCapacity);
+
+	// Truncated clusters keep missing lights until a full cull compacts the list, even when it cannot grow any further
+	if (clusterStatistics.truncatedClusters && !a_full)
+		forceFullCulling = true;
+
+	uint maxCapacity = clusterCount * CLUSTER_MAX_LIGHTS;
+	if (lightIndexCapacity < maxCapacity && (clusterStatistics.truncatedClusters || requiredIndices > lightIndexCapacity - lightIndexCapacity / 4)) {
+		logger::debug("[LLF] Growing light index list from {} to {} entries", lightIndexCapacity, requiredIndices * 2);
+		CreateLightIndexList(requiredIndices * 2);
+		lowOccupancyReadbacks = 0;
+	} else if (a_full && !clusterStatistics.truncatedClusters && requiredIndices * 4 < lightIndexCapacity && lightIndexCapacity > clusterCount * MIN_CLUSTER_LIGHTS) {
+		if (++lowOccupancyReadbacks > LOW_OCCUPANCY_READBACKS) {
+			logger::debug("[LLF] Shrinking light index list from {} to {} entries", lightIndexCapacity, requiredIndices * 2);
+			CreateLightIndexList(std::max(requiredIndices * 2, clusterCount * MIN_CLUSTER_LIGHTS));
+			lowOccupancyReadbacks = 0;
+		}
+	} else {
+		lowOccupancyReadbacks = 0;
+	}
+}
+
 float LightLimitFix::CalculateLightDistance(float3 a_lightPosition, float a_radius)
 {
 	return (a_lightPosition.x * a_lightPosition.x) + (a_lightPosition.y * a_lightPosition.y) + (a_lightPosition.z * a_lightPosition.z) - (a_radius * a_radius);
@@ -950,12 +1245,14 @@ void LightLimitFix::UpdateLights()
 
 	auto context = variableCache->context;
 
+	bool clustersRebuilt = false;
+
 	{
 		auto projMatrixUnjittered = Util::GetCameraData(0).projMatrixUnjittered;
 		float fov = atan(1.0f / static_cast<float4x4>(projMatrixUnjittered).m[0][0]) * 2.0f * (180.0f / 3.14159265359f);
 
 		static float _lightsNear = 0.0f, _lightsFar = 0.0f, _fov = 0.0f;
-		if (fabs(_fov - fov) > 1e-4 || fabs(_lightsNear - lightsNear) > 1e-4 || fabs(_lightsFar - lightsFar) > 1e-4) {
+		if (clusterBuildingDirty || fabs(_fov - fov) > 1e-4 || fabs(_lightsNear - lightsNear) > 1e-4 || fabs(_lightsFar - lightsFar) > 1e-4) {
 			LightBuildingCB updateData{};
 			updateData.InvProjMatrix[0] = DirectX::XMMatrixInverse(nullptr, projMatrixUnjittered);
 			if (eyeCount == 1)
@@ -964,11 +1261,10 @@ void LightLimitFix::UpdateLights()
 				updateData.InvProjMatrix[1] = DirectX::XMMatrixInverse(nullptr, Util::GetCameraData(1).projMatrixUnjittered);
 			updateData.LightsNear = lightsNear;
 			updateData.LightsFar = lightsFar;
+			GetClusterSlicing(lightsNear, lightsFar, updateData.ClusterFarCutoff, updateData.ClusterLogSlices);
 
 			lightBuildingCB->Update(updateData);
-
-			ID3D11Buffer* buffer = lightBuildingCB->CB();
-			context->CSSetConstantBuffers(0, 1, &buffer);
+			lightBuildingCB->CSSet(context, 0);
 
 			ID3D11UnorderedAccessView* clusters_uav = clusters->uav.get();
 			context->CSSetUnorderedAccessViews(0, 1, &clusters_uav, nullptr);
@@ -982,36 +1278,71 @@ void LightLimitFix::UpdateLights()
 			_fov = fov;
 			_lightsNear = lightsNear;
 			_lightsFar = lightsFar;
+			clusterNear = lightsNear;
+			clusterFar = lightsFar;
+			clusterBuildingDirty = false;
+			clustersRebuilt = true;
 		}
 	}
 
-	{
-		lightCount = std::min((uint)lightsData.size(), MAX_LIGHTS);
+	lightCount = std::min((uint)lightsData.size(), MAX_LIGHTS);
+	lightsData.resize(lightCount);
+
+	ReadbackClusterStatistics(context);
 
+	bool lightsChanged = true;
+	cullingMode = UpdateCullingCache(lightsData, clustersRebuilt, lightsChanged);
+
+	if (lightsChanged) {
 		D3D11_MAPPED_SUBRESOURCE mapped;
 		DX::ThrowIfFailed(context->Map(lights->resource.get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped));
 		size_t bytes = sizeof(LightData) * lightCount;
 		memcpy_s(mapped.pData, bytes, lightsData.data(), bytes);
 		context->Unmap(lights->resource.get(), 0);
+	}
+
+	// Last frame's light grid and index list are still valid
+	if (cullingMode == CullingMode::Reused)
+		return;
+
+	{
+		clusterCullingTimer.Begin(context);
+
+		const uint dirtyLightCount = (uint)dirtyLightsData.size();
+		if (dirtyLightCount) {
+			D3D11_MAPPED_SUBRESOURCE mapped;
+			DX::ThrowIfFailed(context->Map(dirtyLights->resource.get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped));
+			size_t bytes = sizeof(DirtyLight) * dirtyLightCount;
+			memcpy_s(mapped.pData, bytes, dirtyLightsData.data(), bytes);
+			context->Unmap(dirtyLights->resource.get(), 0);
+		}
 
 		LightCullingCB updateData{};
 		updateData.LightCount = lightCount;
+		updateData.DirtyLightCount = dirtyLightCount;
+		updateData.LightIndexCapacity = lightIndexCapacity;
 		lightCullingCB->Update(updateData);
 
-		UINT counterReset[4] = { 0, 0, 0, 0 };
-		context->ClearUnorderedAccessViewUint(lightIndexCounter->uav.get(), counterReset);
+		// Incremental updates append to the index list, it is compacted by the next full cull.
+		// Statistics are only cleared here too, so truncation from any append since then stays visible to readbacks that skipped a frame.
+		if (cullingMode == CullingMode::Full) {
+			UINT counterReset[4] = { 0, 0, 0, 0 };
+			context->ClearUnorderedAccessViewUint(lightIndexCounter->uav.get(), counterReset);
+			context->ClearUnorderedAccessViewUint(statistics->uav.get(), counterReset);
+		}
 
-		ID3D11Buffer* buffer = lightCullingCB->CB();
-		context->CSSetConstantBuffers(0, 1, &buffer);
+		lightCullingCB->CSSet(context, 0);
 
-		ID3D11ShaderResourceView* srvs[] = { clusters->srv.get(), lights->srv.get() };
+		ID3D11ShaderResourceView* srvs[] = { clusters->srv.get(), lights->srv.get(), dirtyLights->srv.get() };
 		context->CSSetShaderResources(0, ARRAYSIZE(srvs), srvs);
 
-		ID3D11UnorderedAccessView* uavs[] = { lightIndexCounter->uav.get(), lightIndexList->uav.get(), lightGrid->uav.get() };
+		ID3D11UnorderedAccessView* uavs[] = { lightIndexCounter->uav.get(), lightIndexList->uav.get(), lightGrid->uav.get(), statistics->uav.get() };
 		context->CSSetUnorderedAccessViews(0, ARRAYSIZE(uavs), uavs, nullptr);
 
 		context->CSSetShader(clusterCullingCS, nullptr, 0);
 		context->Dispatch((clusterSize[0] + 15) / 16, (clusterSize[1] + 15) / 16, (clusterSize[2] + 3) / 4);
+
+		clusterCullingTimer.End(context);
 	}
 
 	context->CSSetShader(nullptr, nullptr, 0);
@@ -1019,11 +1350,13 @@ void LightLimitFix::UpdateLights()
 	ID3D11Buffer* null_buffer = nullptr;
 	context->CSSetConstantBuffers(0, 1, &null_buffer);
 
-	ID3D11ShaderResourceView* null_srvs[2] = { nullptr };
-	context->CSSetShaderResources(0, 2, null_srvs);
+	ID3D11ShaderResourceView* null_srvs[3] = { nullptr };
+	context->CSSetShaderResources(0, 3, null_srvs);
+
+	ID3D11UnorderedAccessView* null_uavs[4] = { nullptr };
+	context->CSSetUnorderedAccessViews(0, 4, null_uavs, nullptr);
 
-	ID3D11UnorderedAccessView* null_uavs[3] = { nullptr };
-	context->CSSetUnorderedAccessViews(0, 3, null_uavs, nullptr);
+	QueueClusterStatistics(context, cullingMode == CullingMode::Full);
 }
 
 void LightLimitFix::Hooks::BSBatchRenderer_RenderPassImmediately::thunk(RE::BSRenderPass* Pass, uint32_t Technique, bool AlphaTest, uint32_t RenderFlags)
@@ -68,13 +68,48 @@ public:
 		float4x4 InvProjMatrix[2];
 		float LightsNear;
 		float LightsFar;
-		uint pad0[2];
+		float ClusterFarCutoff;
+		uint ClusterLogSlices;
 	};
 
 	struct alignas(16) LightCullingCB
 	{
 		uint LightCount;
-		uint pad[3];
+		uint DirtyLightCount;
+		uint LightIndexCapacity;
+		uint pad0;
+	};
+
+	struct DirtyLight
+	{
+		float4 positionVS[2];  // w: radius
+	};
+
+	static constexpr uint STATISTICS_LATENCY = 3;
+	static constexpr uint STATISTICS_HISTOGRAM_BINS = 10;
+
+	struct ClusterStatistics
+	{
+		uint maxLights = 0;
+		float meanLights = 0.0f;
+		uint overflowClusters = 0;
+		uint truncatedClusters = 0;
+		uint usedIndices = 0;
+		uint histogram[STATISTICS_HISTOGRAM_BINS]{};
+	};
+
+	struct StatisticsReadback
+	{
+		winrt::com_ptr<ID3D11Buffer> staging;
+		bool pending = false;
+		bool full = false;
+	};
+
+	enum class CullingMode : std::uint32_t
+	{
+		Full,
+		Incremental,
+		Reused
 	};
 
 	struct alignas(16) PerFrame
@@ -82,8 +117,11 @@ public:
 		uint EnableContactShadows;
 		uint EnableLightsVisualisation;
 		uint LightsVisualisationMode;
-		float pad0;
-		uint ClusterSize[4];
+		float ClusterFarCutoff;
+		uint ClusterSize[4];  // w: number of logarithmic Z slices
+		float ClusterNear;
+		float ClusterFar;
+		float pad0[2];
 	};
 
 	PerFrame GetCommonBufferData();
@@ -122,10 +160,35 @@ public:
 	eastl::unique_ptr<Buffer> lightIndexCounter = nullptr;
 	eastl::unique_ptr<Buffer> lightIndexList = nullptr;
 	eastl::unique_ptr<Buffer> lightGrid = nullptr;
+	eastl::unique_ptr<Buffer> dirtyLights = nullptr;
+	eastl::unique_ptr<Buffer> statistics = nullptr;
 
 	std::uint32_t lightCount = 0;
 	float lightsNear = 1;
 	float lightsFar = 16384;
+	// Depth range the clusters were last built with, pixel shaders must slice with the same one
+	float clusterNear = 1;
+	float clusterFar = 16384;
+
+	bool clusterResourcesDirty = false;
+	bool clusterBuildingDirty = true;
+	uint lightIndexCapacity = 0;
+	Util::GPUTimer clusterCullingTimer;
+
+	// Delayed readback of per-cluster statistics, used to size the light index list
+	StatisticsReadback statisticsReadbacks[STATISTICS_LATENCY];
+	uint statisticsReadbackIndex = 0;
+	ClusterStatistics clusterStatistics;
+	uint lowOccupancyReadbacks = 0;
+	bool forceFullCulling = false;
+
+	// Culling results are reused while lights and view are unchanged
+	eastl::vector<LightData> previousLightsData;
+	eastl::vector<DirtyLight> dirtyLightsData;
+	std::uint64_t previousLightsHash = 0;
+	Matrix previousViewMatrix[2]{};
+	uint incrementalCullingFrames = 0;
+	CullingMode cullingMode = CullingMode::Full;
 
 	struct ParticleLightInfo
 	{
@@ -143,7 +206,7 @@ public:
 		RE::NiColorA baseColor;
 	};
 
-	eastl::hash_map<RE::NiNode*, ParticleLightReference> particleLightsReferences;
+	ParticleLights::GeometryCache<ParticleLightReference> particleLightsReferences;
 	eastl::vector<ParticleLightInfo> queuedParticleLights;
 	eastl::vector<ParticleLightInfo> currentParticleLights;
 
@@ -157,8 +220,11 @@ public:
 	bool wasWorld = false;
 	int previousRoomIndex = -1;
 	Util::FrameChecker frameChecker;
+	uint qualityLevel = 0;
 
 	virtual void SetupResources() override;
+	void SetupClusterResources();
+	void CreateLightIndexList(uint a_capacity);
 	virtual void Reset() override;
 
 	virtual void LoadSettings(json& o_json) override;
@@ -171,9 +237,18 @@ public:
 	virtual void PostPostLoad() override;
 	virtual void DataLoaded() override;
 
+	// Level 1 stops turning particles into lights
+	virtual uint GetQualityLevelCount() override { return 2; }
+	virtual void SetQualityLevel(uint a_level) override { qualityLevel = a_level; }
+
 	float CalculateLightDistance(float3 a_lightPosition, float a_radius);
 	void AddCachedParticleLights(eastl::vector<LightData>& lightsData, LightLimitFix::LightData& light);
 	void SetLightPosition(LightLimitFix::LightData& a_light, RE::NiPoint3 a_initialPosition, bool a_cached = true);
+	void GetClusterSlicing(float a_near, float a_far, float& a_farCutoff, uint& a_logSlices);
+	CullingMode UpdateCullingCache(const eastl::vector<LightData>& a_lightsData, bool a_clustersRebuilt, bool& a_lightsChanged);
+	void QueueClusterStatistics(ID3D11DeviceContext* a_context, bool a_full);
+	void ReadbackClusterStatistics(ID3D11DeviceContext* a_context);
+	void UpdateClusterStatistics(const uint* a_data, bool a_full);
 	void UpdateLights();
 	virtual void Prepass() override;
 
@@ -195,6 +270,11 @@ public:
 		float BillboardBrightness = 1.0f;
 		float BillboardRadius = 1.0f;
 		bool EnableParticleLightsOptimization = true;
+		uint ClusterTileSize = 64;
+		uint ClusterSlices = 32;
+		bool EnableNearBiasedSlices = false;
+		float ClusterFarCutoff = 8192.0f;
+		bool EnableClusterCullingCache = true;
 	};
 
 	uint clusterSize[3] = { 16 };
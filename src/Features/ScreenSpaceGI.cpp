@@ -3,6 +3,7 @@
 
 #include "Deferred.h"
 #include "State.h"
+#include "TexturePool.h"
 #include "Util.h"
 
 #include "DirectXTex.h"
@@ -15,6 +16,11 @@ NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(
 	NumSlices,
 	NumSteps,
 	ResolutionMode,
+	TracingInterleave,
+	EnableStereoSharing,
+	EnableAdaptiveQuality,
+	AdaptiveBudget,
+	MinResolutionScale,
 	MinScreenRadius,
 	AORadius,
 	GIRadius,
@@ -160,6 +166,49 @@ void ScreenSpaceGI::DrawSettings()
 		ImGui::EndTable();
 	}
 
+	{
+		auto _ = Util::DisableGuard(!settings.EnableTemporalDenoiser);
+
+		if (ImGui::BeginTable("Interleave", 3)) {
+			ImGui::TableNextColumn();
+			recompileFlag |= ImGui::RadioButton("Trace All", &settings.TracingInterleave, 0);
+			ImGui::TableNextColumn();
+			recompileFlag |= ImGui::RadioButton("Trace 1/2", &settings.TracingInterleave, 1);
+			ImGui::TableNextColumn();
+			recompileFlag |= ImGui::RadioButton("Trace 1/4", &settings.TracingInterleave, 2);
+
+			ImGui::EndTable();
+		}
+		if (auto _tt = Util::HoverTooltipWrapper())
+			ImGui::Text(
+				"Traces only part of the pixels each frame in a rotating pattern, the rest reuse the temporal history.\n"
+				"Disoccluded pixels are always traced. Requires the temporal denoiser.");
+
+		if (REL::Module::IsVR()) {
+			recompileFlag |= ImGui::Checkbox("Stereo Sharing", &settings.EnableStereoSharing);
+			if (auto _tt = Util::HoverTooltipWrapper())
+				ImGui::Text(
+					"Traces the right eye at half the rate and fills the rest from the left eye where the surface is visible to both.\n"
+					"Requires the temporal denoiser.");
+		}
+	}
+
+	recompileFlag |= ImGui::Checkbox("Adaptive Quality", &settings.EnableAdaptiveQuality);
+	if (auto _tt = Util::HoverTooltipWrapper())
+		ImGui::Text(
+			"Lowers internal resolution, slices and steps when SSGI takes longer than the budget.\n"
+			"The settings above become the highest quality used.");
+
+	if (settings.EnableAdaptiveQuality) {
+		ImGui::Indent();
+		ImGui::SliderFloat("GPU Budget", &settings.AdaptiveBudget, 0.25f, 8.f, "%.2f ms", ImGuiSliderFlags_AlwaysClamp);
+		ImGui::SliderFloat("Min Resolution Scale", &settings.MinResolutionScale, 0.25f, 1.f, "%.2f", ImGuiSliderFlags_AlwaysClamp);
+		if (auto _tt = Util::HoverTooltipWrapper())
+			ImGui::Text("Lowest internal resolution relative to the screen.");
+		ImGui::Text("GPU Time: %.2f ms, Resolution: %.0f%%, Slices: %u, Steps: %u", gpuTimer.GetTime(), quality.ResScale * 100.f, quality.NumSlices, quality.NumSteps);
+		ImGui::Unindent();
+	}
+
 	///////////////////////////////
 	ImGui::SeparatorText("Visual");
 
@@ -292,17 +341,18 @@ void ScreenSpaceGI::DrawSettings()
 		ImGui::SliderFloat("View Resize", &debugRescale, 0.f, 1.f);
 
 		BUFFER_VIEWER_NODE(texNoise, debugRescale)
-		BUFFER_VIEWER_NODE(texWorkingDepth, debugRescale)
 		BUFFER_VIEWER_NODE(texPrevGeo, debugRescale)
-		BUFFER_VIEWER_NODE(texRadiance, debugRescale)
-		BUFFER_VIEWER_NODE(texAo[0], debugRescale)
-		BUFFER_VIEWER_NODE(texAo[1], debugRescale)
-		BUFFER_VIEWER_NODE(texIlY[0], debugRescale)
-		BUFFER_VIEWER_NODE(texIlY[1], debugRescale)
-		BUFFER_VIEWER_NODE(texIlCoCg[0], debugRescale)
-		BUFFER_VIEWER_NODE(texIlCoCg[1], debugRescale)
 
-		BUFFER_VIEWER_NODE(deferred->prevDiffuseAmbientTexture, debugRescale)
+		// Only the history outlives the frame, the other intermediates are back in the texture pool
+		if (texAo)
+			BUFFER_VIEWER_NODE(texAo, debugRescale)
+		if (texIlY)
+			BUFFER_VIEWER_NODE(texIlY, debugRescale)
+		if (texIlCoCg)
+			BUFFER_VIEWER_NODE(texIlCoCg, debugRescale)
+
+		if (deferred->prevDiffuseAmbientTexture)
+			BUFFER_VIEWER_NODE(deferred->prevDiffuseAmbientTexture, debugRescale)
 
 		ImGui::TreePop();
 	}
@@ -365,79 +415,26 @@ void ScreenSpaceGI::SetupResources()
 
 		auto mainTex = renderer->GetRuntimeData().renderTargets[RE::RENDER_TARGETS::kMAIN];
 		mainTex.texture->GetDesc(&texDesc);
-		srvDesc.Format = uavDesc.Format = texDesc.Format = DXGI_FORMAT_R11G11B10_FLOAT;
+		texDesc.Format = DXGI_FORMAT_R11G11B10_FLOAT;
 		texDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
-		texDesc.MipLevels = srvDesc.Texture2D.MipLevels = 5;
+		texDesc.MipLevels = 5;
 		texDesc.MiscFlags |= D3D11_RESOURCE_MISC_GENERATE_MIPS;
-
-		{
-			texRadiance = eastl::make_unique<Texture2D>(texDesc);
-			texRadiance->CreateSRV(srvDesc);
-			texRadiance->CreateUAV(uavDesc);
-		}
+		radianceDesc = texDesc;
 
 		texDesc.BindFlags &= ~D3D11_BIND_RENDER_TARGET;
 		texDesc.MiscFlags &= ~D3D11_RESOURCE_MISC_GENERATE_MIPS;
-		texDesc.Format = srvDesc.Format = uavDesc.Format = DXGI_FORMAT_R16_FLOAT;
-
-		{
-			texWorkingDepth = eastl::make_unique<Texture2D>(texDesc);
-			texWorkingDepth->CreateSRV(srvDesc);
-			for (int i = 0; i < 5; ++i) {
-				uavDesc.Texture2D.MipSlice = i;
-				DX::ThrowIfFailed(device->CreateUnorderedAccessView(texWorkingDepth->resource.get(), &uavDesc, uavWorkingDepth[i].put()));
-			}
-		}
-
-		uavDesc.Texture2D.MipSlice = 0;
-		texDesc.MipLevels = srvDesc.Texture2D.MipLevels = 1;
-		srvDesc.Format = uavDesc.Format = texDesc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
-		{
-			texIlY[0] = eastl::make_unique<Texture2D>(texDesc);
-			texIlY[0]->CreateSRV(srvDesc);
-			texIlY[0]->CreateUAV(uavDesc);
-
-			texIlY[1] = eastl::make_unique<Texture2D>(texDesc);
-			texIlY[1]->CreateSRV(srvDesc);
-			texIlY[1]->CreateUAV(uavDesc);
-
-			texGiSpecular[0] = eastl::make_unique<Texture2D>(texDesc);
-			texGiSpecular[0]->CreateSRV(srvDesc);
-			texGiSpecular[0]->CreateUAV(uavDesc);
-
-			texGiSpecular[1] = eastl::make_unique<Texture2D>(texDesc);
-			texGiSpecular[1]->CreateSRV(srvDesc);
-			texGiSpecular[1]->CreateUAV(uavDesc);
-		}
-		srvDesc.Format = uavDesc.Format = texDesc.Format = DXGI_FORMAT_R16G16_FLOAT;
-		{
-			texIlCoCg[0] = eastl::make_unique<Texture2D>(texDesc);
-			texIlCoCg[0]->CreateSRV(srvDesc);
-			texIlCoCg[0]->CreateUAV(uavDesc);
-
-			texIlCoCg[1] = eastl::make_unique<Texture2D>(texDesc);
-			texIlCoCg[1]->CreateSRV(srvDesc);
-			texIlCoCg[1]->CreateUAV(uavDesc);
-		}
+		texDesc.Format = DXGI_FORMAT_R16_FLOAT;
+		workingDepthDesc = texDesc;
 
-		srvDesc.Format = uavDesc.Format = texDesc.Format = DXGI_FORMAT_R8_UNORM;
-		{
-			texAo[0] = eastl::make_unique<Texture2D>(texDesc);
-			texAo[0]->CreateSRV(srvDesc);
-			texAo[0]->CreateUAV(uavDesc);
-
-			texAo[1] = eastl::make_unique<Texture2D>(texDesc);
-			texAo[1]->CreateSRV(srvDesc);
-			texAo[1]->CreateUAV(uavDesc);
+		texDesc.MipLevels = 1;
+		texDesc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+		ilYDesc = texDesc;
 
-			texAccumFrames[0] = eastl::make_unique<Texture2D>(texDesc);
-			texAccumFrames[0]->CreateSRV(srvDesc);
-			texAccumFrames[0]->CreateUAV(uavDesc);
+		texDesc.Format = DXGI_FORMAT_R16G16_FLOAT;
+		ilCoCgDesc = texDesc;
 
-			texAccumFrames[1] = eastl::make_unique<Texture2D>(texDesc);
-			texAccumFrames[1]->CreateSRV(srvDesc);
-			texAccumFrames[1]->CreateUAV(uavDesc);
-		}
+		texDesc.Format = DXGI_FORMAT_R8_UNORM;
+		aoDesc = texDesc;
 
 		srvDesc.Format = uavDesc.Format = texDesc.Format = DXGI_FORMAT_R11G11B10_FLOAT;
 		{
@@ -533,12 +530,21 @@ void ScreenSpaceGI::CompileComputeShaders()
 	for (auto& info : shaderInfos) {
 		if (REL::Module::IsVR())
 			info.defines.push_back({ "VR", "" });
-		if (settings.ResolutionMode == 1)
+		if (settings.EnableAdaptiveQuality)
+			info.defines.push_back({ "ADAPTIVE_RES", "" });
+		else if (settings.ResolutionMode == 1)
 			info.defines.push_back({ "HALF_RES", "" });
-		if (settings.ResolutionMode == 2)
+		else if (settings.ResolutionMode == 2)
 			info.defines.push_back({ "QUARTER_RES", "" });
-		if (settings.EnableTemporalDenoiser)
+		if (settings.EnableTemporalDenoiser) {
 			info.defines.push_back({ "TEMPORAL_DENOISER", "" });
+			if (settings.TracingInterleave == 1)
+				info.defines.push_back({ "INTERLEAVE_HALF", "" });
+			else if (settings.TracingInterleave == 2)
+				info.defines.push_back({ "INTERLEAVE_QUARTER", "" });
+			if (REL::Module::IsVR() && settings.EnableStereoSharing)
+				info.defines.push_back({ "STEREO_SHARING", "" });
+		}
 		if (settings.EnableGI)
 			info.defines.push_back({ "GI", "" });
 		if (settings.EnableExperimentalSpecularGI)
@@ -561,11 +567,54 @@ bool ScreenSpaceGI::ShadersOK()
 	return texNoise && prefilterDepthsCompute && radianceDisoccCompute && giCompute && blurCompute && upsampleCompute;
 }
 
+void ScreenSpaceGI::UpdateQuality()
+{
+	prevResScale = quality.ResScale;
+
+	float maxResScale = 1.0f / (float)(1 << settings.ResolutionMode);
+
+	float ladderWorkload = QUALITY_LADDER[qualityLevel];
+
+	if (!settings.EnableAdaptiveQuality) {
+		// Resolution is baked into the shaders here, so the ladder only scales slices and steps
+		float ladderFactor = std::sqrt(ladderWorkload);
+		quality = { maxResScale, std::max(1u, (uint)std::round(settings.NumSlices * ladderFactor)), std::max(2u, (uint)std::round(settings.NumSteps * ladderFactor)) };
+		adaptiveWorkload = 1.0f;
+		return;
+	}
+
+	// The timer is smoothed and a few frames late, so only react once it has caught up with the last change
+	auto frameCount = RE::BSGraphics::State::GetSingleton()->frameCount;
+	float time = gpuTimer.GetTime();
+	if (time > 0.0f && frameCount - lastAdaptiveUpdate >= ADAPTIVE_UPDATE_INTERVAL) {
+		lastAdaptiveUpdate = frameCount;
+
+		// Back off quickly when over budget, recover slowly to avoid oscillating
+		float ratio = settings.AdaptiveBudget / time;
+		if (std::abs(ratio - 1.0f) > 0.1f)
+			adaptiveWorkload = std::clamp(adaptiveWorkload * std::clamp(ratio, 0.75f, 1.1f), ADAPTIVE_MIN_WORKLOAD, 1.0f);
+	}
+
+	// Tracing cost is roughly pixels * slices * steps, spread the reduction over all three
+	float factor = std::pow(adaptiveWorkload * ladderWorkload, 0.25f);
+
+	float resScale = std::clamp(maxResScale * factor, std::min(settings.MinResolutionScale, maxResScale), maxResScale);
+	quality.ResScale = std::ceil(resScale * 32.0f) / 32.0f;  // coarse steps keep the history stable
+
+	// Both eyes must cover whole pixels or the blur and upsample bleed across the eye boundary
+	if (REL::Module::IsVR()) {
+		float frameWidth = std::floor(Util::ConvertToDynamic(State::GetSingleton()->screenSize).x);
+		quality.ResScale = std::min(std::ceil(frameWidth * quality.ResScale * 0.5f) * 2.0f / frameWidth, 1.0f);
+	}
+	quality.NumSlices = std::max(1u, (uint)std::round(settings.NumSlices * factor));
+	quality.NumSteps = std::max(2u, (uint)std::round(settings.NumSteps * factor));
+}
+
 void ScreenSpaceGI::UpdateSB()
 {
 	auto viewport = RE::BSGraphics::State::GetSingleton();
 
-	float2 res = { (float)texRadiance->desc.Width, (float)texRadiance->desc.Height };
+	float2 res = { (float)radianceDesc.Width, (float)radianceDesc.Height };
 	float2 dynres = Util::ConvertToDynamic(res);
 	dynres = { floor(dynres.x), floor(dynres.y) };
 
@@ -591,8 +640,8 @@ void ScreenSpaceGI::UpdateSB()
 		data.RcpFrameDim = float2(1.0f) / dynres;
 		data.FrameIndex = viewport->frameCount;
 
-		data.NumSlices = settings.NumSlices;
-		data.NumSteps = settings.NumSteps;
+		data.NumSlices = quality.NumSlices;
+		data.NumSteps = quality.NumSteps;
 		data.MinScreenRadius = settings.MinScreenRadius * dynres.x;
 
 		data.EffectRadius = std::max(settings.AORadius, settings.GIRadius);
@@ -615,6 +664,12 @@ void ScreenSpaceGI::UpdateSB()
 		data.MaxAccumFrames = settings.MaxAccumFrames;
 		data.BlurRadius = settings.BlurRadius;
 		data.DistanceNormalisation = settings.DistanceNormalisation;
+
+		data.ResScale = quality.ResScale;
+		data.RcpResScale = 1.0f / quality.ResScale;
+		data.PrevResScale = prevResScale;
+		data.RcpPrevResScale = 1.0f / prevResScale;
+		data.ResMip = std::min(2u, (uint)std::floor(std::log2(data.RcpResScale) + 1e-3f));
 	}
 
 	ssgiCB->Update(data);
@@ -623,31 +678,78 @@ void ScreenSpaceGI::UpdateSB()
 void ScreenSpaceGI::DrawSSGI(Texture2D* srcPrevAmbient)
 {
 	auto& context = State::GetSingleton()->context;
+	auto texturePool = TexturePool::GetSingleton();
 
 	if (!(settings.Enabled && ShadersOK())) {
-		FLOAT clr[4] = { 0.f, 0.f, 0.f, 0.f };
-		context->ClearUnorderedAccessViewFloat(texAo[outputAoIdx]->uav.get(), clr);
-		context->ClearUnorderedAccessViewFloat(texIlY[outputIlIdx]->uav.get(), clr);
-		context->ClearUnorderedAccessViewFloat(texIlCoCg[outputIlIdx]->uav.get(), clr);
+		ReleaseHistory();
+
+		if (settings.Enabled) {
+			FLOAT clr[4] = { 0.f, 0.f, 0.f, 0.f };
+			outputAo = texturePool->Acquire(aoDesc);
+			outputIlY = texturePool->Acquire(ilYDesc);
+			outputIlCoCg = texturePool->Acquire(ilCoCgDesc);
+			context->ClearUnorderedAccessViewFloat(outputAo->uav.get(), clr);
+			context->ClearUnorderedAccessViewFloat(outputIlY->uav.get(), clr);
+			context->ClearUnorderedAccessViewFloat(outputIlCoCg->uav.get(), clr);
+		}
 		return;
 	}
 
 	ZoneScoped;
 	TracyD3D11Zone(State::GetSingleton()->tracyCtx, "SSGI");
 
-	static uint lastFrameAoTexIdx = 0;
-	static uint lastFrameGITexIdx = 0;
-	static uint lastFrameAccumTexIdx = 0;
-	uint inputAoTexIdx = lastFrameAoTexIdx;
-	uint inputGITexIdx = lastFrameGITexIdx;
-
 	//////////////////////////////////////////////////////
 
 	if (recompileFlag)
 		ClearShaderCache();
 
+	UpdateQuality();
 	UpdateSB();
 
+	// History starts out black, specular GI only has one while the shaders use it
+	bool specularGI = settings.EnableExperimentalSpecularGI;
+	auto acquireHistory = [&](Texture2D*& a_texture, const D3D11_TEXTURE2D_DESC& a_desc) {
+		if (!a_texture) {
+			FLOAT clr[4] = { 0.f, 0.f, 0.f, 0.f };
+			a_texture = texturePool->Acquire(a_desc);
+			context->ClearUnorderedAccessViewFloat(a_texture->uav.get(), clr);
+		}
+	};
+	acquireHistory(texAccumFrames, aoDesc);
+	acquireHistory(texAo, aoDesc);
+	acquireHistory(texIlY, ilYDesc);
+	acquireHistory(texIlCoCg, ilCoCgDesc);
+	if (specularGI) {
+		acquireHistory(texGiSpecular, ilYDesc);
+	} else {
+		texturePool->Release(texGiSpecular);
+		texGiSpecular = nullptr;
+	}
+
+	// The per-mip views follow whichever pooled texture backs the working depth this frame
+	texWorkingDepth = texturePool->Acquire(workingDepthDesc);
+	{
+		winrt::com_ptr<ID3D11Resource> workingDepthResource;
+		if (uavWorkingDepth[0])
+			uavWorkingDepth[0]->GetResource(workingDepthResource.put());
+
+		if (workingDepthResource.get() != texWorkingDepth->resource.get()) {
+			auto& device = State::GetSingleton()->device;
+			D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {
+				.Format = workingDepthDesc.Format,
+				.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2D,
+				.Texture2D = { .MipSlice = 0 }
+			};
+			for (uint i = 0; i < 5; ++i) {
+				uavDesc.Texture2D.MipSlice = i;
+				uavWorkingDepth[i] = nullptr;
+				DX::ThrowIfFailed(device->CreateUnorderedAccessView(texWorkingDepth->resource.get(), &uavDesc, uavWorkingDepth[i].put()));
+			}
+		}
+	}
+
+	gpuTimer.Begin(context);
+
 	//////////////////////////////////////////////////////
 
 	auto renderer = RE::BSGraphics::Renderer::GetSingleton();
@@ -659,7 +761,9 @@ void ScreenSpaceGI::DrawSSGI(Texture2D* srcPrevAmbient)
 	auto resChoices = std::array{
 		resolution, std::array{ resolution[0] >> 1, resolution[1] >> 1 }, std::array{ resolution[0] >> 2, resolution[1] >> 2 }
 	};
-	auto internalRes = resChoices[settings.ResolutionMode];
+	auto internalRes = settings.EnableAdaptiveQuality ?
+	                       std::array{ (uint)std::ceil(size.x * quality.ResScale), (uint)std::ceil(size.y * quality.ResScale) } :
+	                       resChoices[settings.ResolutionMode];
 
 	std::array<ID3D11ShaderResourceView*, 11> srvs = { nullptr };
 	std::array<ID3D11UnorderedAccessView*, 6> uavs = { nullptr };
@@ -674,6 +778,10 @@ void ScreenSpaceGI::DrawSSGI(Texture2D* srcPrevAmbient)
 		context->CSSetUnorderedAccessViews(0, (uint)uavs.size(), uavs.data(), nullptr);
 	};
 
+	// Specular GI textures are null without GI_SPECULAR, reads return zero and writes are dropped
+	auto srv = [](Texture2D* a_texture) { return a_texture ? a_texture->srv.get() : nullptr; };
+	auto uav = [](Texture2D* a_texture) { return a_texture ? a_texture->uav.get() : nullptr; };
+
 	//////////////////////////////////////////////////////
 
 	context->CSSetConstantBuffers(1, 1, &cb);
@@ -696,6 +804,14 @@ void ScreenSpaceGI::DrawSSGI(Texture2D* srcPrevAmbient)
 	// fetch radiance and disocclusion
 	{
 		TracyD3D11Zone(State::GetSingleton()->tracyCtx, "SSGI - Radiance Disocc");
+		TexturePool::Pass pass;
+
+		texRadiance = pass.Write(radianceDesc);
+		auto newAccumFrames = pass.Write(aoDesc);
+		auto newAo = pass.Write(aoDesc);
+		auto newIlY = pass.Write(ilYDesc);
+		auto newIlCoCg = pass.Write(ilCoCgDesc);
+		auto newGiSpecular = specularGI ? pass.Write(ilYDesc) : nullptr;
 
 		resetViews();
 		srvs.at(0) = rts[deferred->forwardRenderTargets[0]].SRV;
@@ -703,19 +819,19 @@ void ScreenSpaceGI::DrawSSGI(Texture2D* srcPrevAmbient)
 		srvs.at(2) = rts[NORMALROUGHNESS].SRV;
 		srvs.at(3) = texPrevGeo->srv.get();
 		srvs.at(4) = rts[RE::RENDER_TARGET::kMOTION_VECTOR].SRV;
-		srvs.at(5) = srcPrevAmbient->srv.get();
-		srvs.at(6) = texAccumFrames[lastFrameAccumTexIdx]->srv.get();
-		srvs.at(7) = texAo[inputAoTexIdx]->srv.get();
-		srvs.at(8) = texIlY[inputGITexIdx]->srv.get();
-		srvs.at(9) = texIlCoCg[inputGITexIdx]->srv.get();
-		srvs.at(10) = texGiSpecular[inputAoTexIdx]->srv.get();
+		srvs.at(5) = srv(srcPrevAmbient);
+		srvs.at(6) = pass.ReadLast(texAccumFrames)->srv.get();
+		srvs.at(7) = pass.ReadLast(texAo)->srv.get();
+		srvs.at(8) = pass.ReadLast(texIlY)->srv.get();
+		srvs.at(9) = pass.ReadLast(texIlCoCg)->srv.get();
+		srvs.at(10) = srv(pass.ReadLast(texGiSpecular));
 
 		uavs.at(0) = texRadiance->uav.get();
-		uavs.at(1) = texAccumFrames[!lastFrameAccumTexIdx]->uav.get();
-		uavs.at(2) = texAo[!inputAoTexIdx]->uav.get();
-		uavs.at(3) = texIlY[!inputGITexIdx]->uav.get();
-		uavs.at(4) = texIlCoCg[!inputGITexIdx]->uav.get();
-		uavs.at(5) = texGiSpecular[!inputAoTexIdx]->uav.get();
+		uavs.at(1) = newAccumFrames->uav.get();
+		uavs.at(2) = newAo->uav.get();
+		uavs.at(3) = newIlY->uav.get();
+		uavs.at(4) = newIlCoCg->uav.get();
+		uavs.at(5) = uav(newGiSpecular);
 
 		context->CSSetShaderResources(0, (uint)srvs.size(), srvs.data());
 		context->CSSetUnorderedAccessViews(0, (uint)uavs.size(), uavs.data(), nullptr);
@@ -724,30 +840,38 @@ void ScreenSpaceGI::DrawSSGI(Texture2D* srcPrevAmbient)
 
 		context->GenerateMips(texRadiance->srv.get());
 
-		inputAoTexIdx = !inputAoTexIdx;
-		inputGITexIdx = !inputGITexIdx;
-		lastFrameAccumTexIdx = !lastFrameAccumTexIdx;
+		texAccumFrames = newAccumFrames;
+		texAo = newAo;
+		texIlY = newIlY;
+		texIlCoCg = newIlCoCg;
+		texGiSpecular = newGiSpecular;
 	}
 
 	// GI
 	{
 		TracyD3D11Zone(State::GetSingleton()->tracyCtx, "SSGI - GI");
+		TexturePool::Pass pass;
+
+		auto newAo = pass.Write(aoDesc);
+		auto newIlY = pass.Write(ilYDesc);
+		auto newIlCoCg = pass.Write(ilCoCgDesc);
+		auto newGiSpecular = specularGI ? pass.Write(ilYDesc) : nullptr;
 
 		resetViews();
 		srvs.at(0) = texWorkingDepth->srv.get();
 		srvs.at(1) = rts[NORMALROUGHNESS].SRV;
-		srvs.at(2) = texRadiance->srv.get();
+		srvs.at(2) = pass.ReadLast(texRadiance)->srv.get();
 		srvs.at(3) = texNoise->srv.get();
-		srvs.at(4) = texAccumFrames[lastFrameAccumTexIdx]->srv.get();
-		srvs.at(5) = texAo[inputAoTexIdx]->srv.get();
-		srvs.at(6) = texIlY[inputGITexIdx]->srv.get();
-		srvs.at(7) = texIlCoCg[inputGITexIdx]->srv.get();
-		srvs.at(8) = texGiSpecular[inputAoTexIdx]->srv.get();
-
-		uavs.at(0) = texAo[!inputAoTexIdx]->uav.get();
-		uavs.at(1) = texIlY[!inputGITexIdx]->uav.get();
-		uavs.at(2) = texIlCoCg[!inputGITexIdx]->uav.get();
-		uavs.at(3) = texGiSpecular[!inputAoTexIdx]->uav.get();
+		srvs.at(4) = texAccumFrames->srv.get();
+		srvs.at(5) = pass.ReadLast(texAo)->srv.get();
+		srvs.at(6) = pass.ReadLast(texIlY)->srv.get();
+		srvs.at(7) = pass.ReadLast(texIlCoCg)->srv.get();
+		srvs.at(8) = srv(pass.ReadLast(texGiSpecular));
+
+		uavs.at(0) = newAo->uav.get();
+		uavs.at(1) = newIlY->uav.get();
+		uavs.at(2) = newIlCoCg->uav.get();
+		uavs.at(3) = uav(newGiSpecular);
 		uavs.at(4) = texPrevGeo->uav.get();
 
 		context->CSSetShaderResources(0, (uint)srvs.size(), srvs.data());
@@ -755,62 +879,79 @@ void ScreenSpaceGI::DrawSSGI(Texture2D* srcPrevAmbient)
 		context->CSSetShader(giCompute.get(), nullptr, 0);
 		context->Dispatch((internalRes[0] + 7u) >> 3, (internalRes[1] + 7u) >> 3, 1);
 
-		inputAoTexIdx = !inputAoTexIdx;
-		inputGITexIdx = !inputGITexIdx;
-		lastFrameGITexIdx = inputGITexIdx;
-		lastFrameAoTexIdx = inputAoTexIdx;
+		texRadiance = nullptr;
+		texAo = newAo;
+		texIlY = newIlY;
+		texIlCoCg = newIlCoCg;
+		texGiSpecular = newGiSpecular;
 	}
 
 	// blur
 	if (settings.EnableBlur) {
 		TracyD3D11Zone(State::GetSingleton()->tracyCtx, "SSGI - Diffuse Blur");
+		TexturePool::Pass pass;
+
+		auto newAccumFrames = pass.Write(aoDesc);
+		auto newIlY = pass.Write(ilYDesc);
+		auto newIlCoCg = pass.Write(ilCoCgDesc);
 
 		resetViews();
 		srvs.at(0) = texWorkingDepth->srv.get();
 		srvs.at(1) = rts[NORMALROUGHNESS].SRV;
-		srvs.at(2) = texAccumFrames[lastFrameAccumTexIdx]->srv.get();
-		srvs.at(3) = texIlY[inputGITexIdx]->srv.get();
-		srvs.at(4) = texIlCoCg[inputGITexIdx]->srv.get();
+		srvs.at(2) = pass.ReadLast(texAccumFrames)->srv.get();
+		srvs.at(3) = pass.ReadLast(texIlY)->srv.get();
+		srvs.at(4) = pass.ReadLast(texIlCoCg)->srv.get();
 
-		uavs.at(0) = texAccumFrames[!lastFrameAccumTexIdx]->uav.get();
-		uavs.at(1) = texIlY[!inputGITexIdx]->uav.get();
-		uavs.at(2) = texIlCoCg[!inputGITexIdx]->uav.get();
+		uavs.at(0) = newAccumFrames->uav.get();
+		uavs.at(1) = newIlY->uav.get();
+		uavs.at(2) = newIlCoCg->uav.get();
 
 		context->CSSetShaderResources(0, (uint)srvs.size(), srvs.data());
 		context->CSSetUnorderedAccessViews(0, (uint)uavs.size(), uavs.data(), nullptr);
 		context->CSSetShader(blurCompute.get(), nullptr, 0);
 		context->Dispatch((internalRes[0] + 7u) >> 3, (internalRes[1] + 7u) >> 3, 1);
 
-		inputGITexIdx = !inputGITexIdx;
-		lastFrameGITexIdx = inputGITexIdx;
-		lastFrameAccumTexIdx = !lastFrameAccumTexIdx;
+		texAccumFrames = newAccumFrames;
+		texIlY = newIlY;
+		texIlCoCg = newIlCoCg;
 	}
 
+	outputAo = texAo;
+	outputIlY = texIlY;
+	outputIlCoCg = texIlCoCg;
+	outputGiSpecular = texGiSpecular;
+
 	// upsasmple
-	if (settings.ResolutionMode != 0) {
+	if (quality.ResScale < 1.0f) {
+		TexturePool::Pass pass;
+
+		outputAo = pass.Write(aoDesc);
+		outputIlY = pass.Write(ilYDesc);
+		outputIlCoCg = pass.Write(ilCoCgDesc);
+		outputGiSpecular = specularGI ? pass.Write(ilYDesc) : nullptr;
+
 		resetViews();
 		srvs.at(0) = texWorkingDepth->srv.get();
-		srvs.at(1) = texAo[inputAoTexIdx]->srv.get();
-		srvs.at(2) = texIlY[inputGITexIdx]->srv.get();
-		srvs.at(3) = texIlCoCg[inputGITexIdx]->srv.get();
-		srvs.at(4) = texGiSpecular[inputAoTexIdx]->srv.get();
+		srvs.at(1) = texAo->srv.get();
+		srvs.at(2) = texIlY->srv.get();
+		srvs.at(3) = texIlCoCg->srv.get();
+		srvs.at(4) = srv(texGiSpecular);
 
-		uavs.at(0) = texAo[!inputAoTexIdx]->uav.get();
-		uavs.at(1) = texIlY[!inputGITexIdx]->uav.get();
-		uavs.at(2) = texIlCoCg[!inputGITexIdx]->uav.get();
-		uavs.at(3) = texGiSpecular[!inputAoTexIdx]->uav.get();
+		uavs.at(0) = outputAo->uav.get();
+		uavs.at(1) = outputIlY->uav.get();
+		uavs.at(2) = outputIlCoCg->uav.get();
+		uavs.at(3) = uav(outputGiSpecular);
 
 		context->CSSetShaderResources(0, (uint)srvs.size(), srvs.data());
 		context->CSSetUnorderedAccessViews(0, (uint)uavs.size(), uavs.data(), nullptr);
 		context->CSSetShader(upsampleCompute.get(), nullptr, 0);
 		context->Dispatch((resolution[0] + 7u) >> 3, (resolution[1] + 7u) >> 3, 1);
-
-		inputAoTexIdx = !inputAoTexIdx;
-		inputGITexIdx = !inputGITexIdx;
 	}
 
-	outputAoIdx = inputAoTexIdx;
-	outputIlIdx = inputGITexIdx;
+	gpuTimer.End(context);
+
+	texturePool->Release(texWorkingDepth);
+	texWorkingDepth = nullptr;
 
 	// cleanup
 	resetViews();
@@ -821,4 +962,31 @@ void ScreenSpaceGI::DrawSSGI(Texture2D* srcPrevAmbient)
 	context->CSSetConstantBuffers(1, 1, &cb);
 	context->CSSetSamplers(0, (uint)samplers.size(), samplers.data());
 	context->CSSetShader(nullptr, nullptr, 0);
+}
+
+void ScreenSpaceGI::ReleaseOutputs()
+{
+	auto texturePool = TexturePool::GetSingleton();
+	if (outputAo != texAo)
+		texturePool->Release(outputAo);
+	if (outputIlY != texIlY)
+		texturePool->Release(outputIlY);
+	if (outputIlCoCg != texIlCoCg)
+		texturePool->Release(outputIlCoCg);
+	if (outputGiSpecular != texGiSpecular)
+		texturePool->Release(outputGiSpecular);
+
+	outputAo = outputIlY = outputIlCoCg = outputGiSpecular = nullptr;
+}
+
+void ScreenSpaceGI::ReleaseHistory()
+{
+	auto texturePool = TexturePool::GetSingleton();
+	for (auto texture : { &texAccumFrames, &texAo, &texIlY, &texIlCoCg, &texGiSpecular }) {
+		texturePool->Release(*texture);
+		*texture = nullptr;
+	}
+
+	for (auto& uav : uavWorkingDepth)
+		uav = nullptr;
 }
\ No newline at end of file
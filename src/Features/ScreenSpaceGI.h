@@ -2,6 +2,7 @@
 
 #include "Buffer.h"
 #include "Feature.h"
+#include "Util.h"
 
 struct ScreenSpaceGI : Feature
 {
@@ -31,17 +32,22 @@ struct ScreenSpaceGI : Feature
 
 	virtual void SetupResources() override;
 	virtual void ClearShaderCache() override;
+
+	virtual uint GetQualityLevelCount() override { return (uint)std::size(QUALITY_LADDER); }
+	virtual void SetQualityLevel(uint a_level) override { qualityLevel = a_level; }
+
 	void CompileComputeShaders();
 	bool ShadersOK();
 
 	void DrawSSGI(Texture2D* srcPrevAmbient);
+	void ReleaseOutputs();
+	void ReleaseHistory();
+	void UpdateQuality();
 	void UpdateSB();
 
 	//////////////////////////////////////////////////////////////////////////////////
 
 	bool recompileFlag = false;
-	uint outputAoIdx = 0;
-	uint outputIlIdx = 0;
 
 	struct Settings
 	{
@@ -51,7 +57,12 @@ struct ScreenSpaceGI : Feature
 		// performance/quality
 		uint NumSlices = 5;
 		uint NumSteps = 8;
-		int ResolutionMode = 1;  // 0-full, 1-half, 2-quarter
+		int ResolutionMode = 1;     // 0-full, 1-half, 2-quarter
+		int TracingInterleave = 0;  // 0-every pixel, 1-half, 2-quarter
+		bool EnableStereoSharing = true;
+		bool EnableAdaptiveQuality = false;
+		float AdaptiveBudget = 1.5f;  // ms
+		float MinResolutionScale = 0.25f;
 		// visual
 		float MinScreenRadius = 0.01f;
 		float AORadius = 100.f;
@@ -113,30 +124,68 @@ struct ScreenSpaceGI : Feature
 
 		float BlurRadius;
 		float DistanceNormalisation;
+		float ResScale;
+		float RcpResScale;
 
-		float pad[2];
+		float PrevResScale;
+		float RcpPrevResScale;
+		uint ResMip;
+
+		float pad[1];
 	};
 	eastl::unique_ptr<ConstantBuffer> ssgiCB;
 
+	// Quality actually used this frame, driven by the GPU timer when adaptive quality is on
+	struct Quality
+	{
+		float ResScale = 1.0f;
+		uint NumSlices = 5;
+		uint NumSteps = 8;
+	} quality;
+	float prevResScale = 1.0f;
+
+	static constexpr uint ADAPTIVE_UPDATE_INTERVAL = 16;
+	static constexpr float ADAPTIVE_MIN_WORKLOAD = 1.0f / 64.0f;
+	Util::GPUTimer gpuTimer;
+	float adaptiveWorkload = 1.0f;
+	uint lastAdaptiveUpdate = 0;
+
+	// Workload of each frame budget level, resolution only follows when adaptive quality is on
+	static constexpr float QUALITY_LADDER[] = { 1.0f, 0.7f, 0.5f, 0.35f };
+	uint qualityLevel = 0;
+
 	eastl::unique_ptr<Texture2D> texNoise = nullptr;
-	eastl::unique_ptr<Texture2D> texWorkingDepth = nullptr;
-	winrt::com_ptr<ID3D11UnorderedAccessView> uavWorkingDepth[5] = { nullptr };
 	eastl::unique_ptr<Texture2D> texPrevGeo = nullptr;
-	eastl::unique_ptr<Texture2D> texRadiance = nullptr;
-	eastl::unique_ptr<Texture2D> texAccumFrames[2] = { nullptr };
-	eastl::unique_ptr<Texture2D> texAo[2] = { nullptr };
-	eastl::unique_ptr<Texture2D> texIlY[2] = { nullptr };
-	eastl::unique_ptr<Texture2D> texIlCoCg[2] = { nullptr };
-	eastl::unique_ptr<Texture2D> texGiSpecular[2] = { nullptr };
+
+	// Intermediates come from the texture pool, each pass writes new ones and hands back what it read last
+	D3D11_TEXTURE2D_DESC workingDepthDesc{};
+	D3D11_TEXTURE2D_DESC radianceDesc{};
+	D3D11_TEXTURE2D_DESC aoDesc{};  // also accumulated frames
+	D3D11_TEXTURE2D_DESC ilYDesc{};  // also specular GI
+	D3D11_TEXTURE2D_DESC ilCoCgDesc{};
+
+	Texture2D* texWorkingDepth = nullptr;
+	winrt::com_ptr<ID3D11UnorderedAccessView> uavWorkingDepth[5] = { nullptr };
+	Texture2D* texRadiance = nullptr;
+
+	// Temporal history, kept from one frame to the next
+	Texture2D* texAccumFrames = nullptr;
+	Texture2D* texAo = nullptr;
+	Texture2D* texIlY = nullptr;
+	Texture2D* texIlCoCg = nullptr;
+	Texture2D* texGiSpecular = nullptr;
+
+	// Same as the history unless upsampled, released once the deferred composite is done with them
+	Texture2D* outputAo = nullptr;
+	Texture2D* outputIlY = nullptr;
+	Texture2D* outputIlCoCg = nullptr;
+	Texture2D* outputGiSpecular = nullptr;
 
 	inline auto GetOutputTextures()
 	{
+		auto srv = [](Texture2D* a_texture) { return a_texture ? a_texture->srv.get() : nullptr; };
 		return (loaded && settings.Enabled) ?
-		           std::make_tuple(
-					   texAo[outputAoIdx]->srv.get(),
-					   texIlY[outputIlIdx]->srv.get(),
-					   texIlCoCg[outputIlIdx]->srv.get(),
-					   texGiSpecular[outputAoIdx]->srv.get()) :
+		           std::make_tuple(srv(outputAo), srv(outputIlY), srv(outputIlCoCg), srv(outputGiSpecular)) :
 		           std::make_tuple(nullptr, nullptr, nullptr, nullptr);
 	}
 
@@ -1,6 +1,7 @@
 #include "ScreenSpaceShadows.h"
 
 #include "Deferred.h"
+#include "ExtendedRendererState.h"
 #include "State.h"
 #include "Util.h"
 
@@ -233,8 +234,7 @@ void ScreenSpaceShadows::Prepass()
 		if (bendSettings.Enable && sky->mode.get() == RE::Sky::Mode::kFull)
 			DrawShadows();
 
-	auto view = screenSpaceShadowsTexture->srv.get();
-	context->PSSetShaderResources(45, 1, &view);
+	ExtendedRendererState::GetSingleton()->SetPSResource(45, screenSpaceShadowsTexture->srv.get());
 }
 
 void ScreenSpaceShadows::LoadSettings(json& o_json)
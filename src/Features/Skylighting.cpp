@@ -2,6 +2,7 @@
 
 #include <DDSTextureLoader.h>
 
+#include "ExtendedRendererState.h"
 #include "ScreenSpaceGI.h"
 #include "ShaderCache.h"
 #include "VariableCache.h"
@@ -11,7 +12,68 @@ NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(
 	MaxZenith,
 	MinDiffuseVisibility,
 	MinSpecularVisibility,
-	SSGIAmbientDimmer)
+	SSGIAmbientDimmer,
+	EnableIncrementalUpdates,
+	ProbeUpdateBudget,
+	OcclusionUpdateInterval,
+	OcclusionUpdateDistance)
+
+namespace
+{
+	// Mirrors the probe coefficient encoding of packProbe and unpackProbe in Skylighting.hlsli
+	constexpr float ProbeL0Range = 3.5449077f;                 // sqrt(4 pi)
+	constexpr float ProbeL1Range = 1.7320508f * ProbeL0Range;  // sqrt(3) * L0
+	constexpr float ProbeCoeffScale = 8191.f;
+
+	constexpr uint EncodeProbeCoeff(float a_delta, float a_range)
+	{
+		return (uint)(std::clamp(a_delta / a_range, -1.f, 1.f) * ProbeCoeffScale + ProbeCoeffScale + 0.5f);
+	}
+
+	constexpr float DecodeProbeCoeff(uint a_coeff, float a_range)
+	{
+		return ((float)(a_coeff & 0x3FFF) / ProbeCoeffScale - 1.f) * a_range;
+	}
+
+	constexpr uint ProbeCodeCount = 2 * (uint)ProbeCoeffScale + 1;
+	constexpr uint ProbeCodesPerCheck = 1024;  // codes per constant evaluation, the whole range at once exceeds the compiler step limit
+
+	// Sweeps the codes from a_firstCode, checking coefficients at and between consecutive codes.
+	// Every coefficient in [-a_range, a_range] must decode within half a quantisation step, a_range / 16382.
+	constexpr bool ProbeCodesWithinHalfStep(float a_range, uint a_firstCode)
+	{
+		const float halfStep = 0.5f * a_range / ProbeCoeffScale;
+		const float maxError = halfStep + a_range * 1e-6f;  // plus a few float ulps for the encode and decode
+		const uint lastCode = std::min(a_firstCode + ProbeCodesPerCheck, ProbeCodeCount - 1);
+		for (uint code = a_firstCode; code < lastCode; code++) {
+			const float value = DecodeProbeCoeff(code, a_range);
+			const float next = DecodeProbeCoeff(code + 1, a_range);
+			for (float t : { 0.f, 0.25f, 0.5f, 0.75f }) {
+				const float delta = value + (next - value) * t;
+				const float error = DecodeProbeCoeff(EncodeProbeCoeff(delta, a_range), a_range) - delta;
+				if (error > maxError || -error > maxError)
+					return false;
+			}
+		}
+		return true;
+	}
+
+	template <uint Range, uint Chunk>
+	constexpr bool ProbeChunkWithinHalfStep = ProbeCodesWithinHalfStep(Range == 0 ? ProbeL0Range : ProbeL1Range, Chunk * ProbeCodesPerCheck);
+
+	template <uint Range, uint... Chunks>
+	constexpr bool ProbeRangeWithinHalfStep(std::integer_sequence<uint, Chunks...>)
+	{
+		return (ProbeChunkWithinHalfStep<Range, Chunks> && ...);
+	}
+
+	constexpr auto ProbeCodeChunks = std::make_integer_sequence<uint, (ProbeCodeCount + ProbeCodesPerCheck - 1) / ProbeCodesPerCheck>();
+
+	static_assert(EncodeProbeCoeff(2.f * ProbeL1Range, ProbeL1Range) == ProbeCodeCount - 1 && EncodeProbeCoeff(-2.f * ProbeL1Range, ProbeL1Range) == 0, "out of range coefficients must saturate within 14 bits");
+	static_assert(DecodeProbeCoeff(EncodeProbeCoeff(0.f, ProbeL0Range), ProbeL0Range) == 0.f, "a unit SH must decode exactly");
+	static_assert(ProbeRangeWithinHalfStep<0>(ProbeCodeChunks), "L0 coefficients must decode within 2.2e-4");
+	static_assert(ProbeRangeWithinHalfStep<1>(ProbeCodeChunks), "L1 coefficients must decode within 3.8e-4");
+}
 
 void Skylighting::LoadSettings(json& o_json)
 {
@@ -31,9 +93,14 @@ void Skylighting::RestoreDefaultSettings()
 void Skylighting::ResetSkylighting()
 {
 	auto& context = State::GetSingleton()->context;
-	UINT clr[1] = { 0 };
-	context->ClearUnorderedAccessViewUint(texAccumFramesArray->uav.get(), clr);
+	// Unit SH (fully visible) with no accumulated frames in both channels of every probe
+	constexpr UINT unitCoeff = EncodeProbeCoeff(0.f, ProbeL0Range);
+	UINT clr[4] = { unitCoeff | (unitCoeff << 14), unitCoeff | (unitCoeff << 14), 0, 0 };
+	context->ClearUnorderedAccessViewUint(texProbeArray->uav.get(), clr);
 	queuedResetSkylighting = false;
+
+	// Converge quickly after a reset before time slicing the refinement
+	fullUpdateFrames = 64;
 }
 
 void Skylighting::DrawSettings()
@@ -58,6 +125,35 @@ void Skylighting::DrawSettings()
 	ImGui::SliderAngle("Max Zenith Angle", &settings.MaxZenith, 0, 90);
 	if (auto _tt = Util::HoverTooltipWrapper())
 		ImGui::Text("Smaller angles creates more focused top-down shadow.");
+
+	ImGui::Separator();
+
+	ImGui::Checkbox("Incremental Probe Updates", &settings.EnableIncrementalUpdates);
+	if (auto _tt = Util::HoverTooltipWrapper())
+		ImGui::Text(
+			"Only probes scrolled in by camera movement are updated every frame. "
+			"The rest of the volume is refined a few slices at a time.");
+
+	{
+		auto _ = Util::DisableGuard(!settings.EnableIncrementalUpdates);
+
+		const uint sliceSize = probeArrayDims[0] * probeArrayDims[1];
+		int slices = (int)std::clamp(settings.ProbeUpdateBudget / sliceSize, 1u, probeArrayDims[2]);
+		if (ImGui::SliderInt("Probe Update Budget", &slices, 1, (int)probeArrayDims[2], std::format("{} slices ({:.2f}M probes)", slices, slices * sliceSize / 1e6f).c_str()))
+			settings.ProbeUpdateBudget = slices * sliceSize;
+		if (auto _tt = Util::HoverTooltipWrapper())
+			ImGui::Text("Number of probes refined per frame. Lower budgets are cheaper but take longer to converge.");
+	}
+
+	ImGui::SliderInt("Occlusion Update Interval", (int*)&settings.OcclusionUpdateInterval, 1, 8, "%d frames", ImGuiSliderFlags_AlwaysClamp);
+	if (auto _tt = Util::HoverTooltipWrapper())
+		ImGui::Text(
+			"How often the occlusion height map is rendered. Each render is one extra geometry pass and one sample for the probes, "
+			"so higher intervals are cheaper but take longer to converge.");
+
+	ImGui::SliderFloat("Occlusion Update Distance", &settings.OcclusionUpdateDistance, 0.0f, 1024.0f, "%.0f units");
+	if (auto _tt = Util::HoverTooltipWrapper())
+		ImGui::Text("Camera movement which renders the occlusion height map regardless of the interval.");
 }
 
 void Skylighting::SetupResources()
@@ -87,7 +183,7 @@ void Skylighting::SetupResources()
 			.Height = probeArrayDims[1],
 			.Depth = probeArrayDims[2],
 			.MipLevels = 1,
-			.Format = DXGI_FORMAT_R16G16B16A16_FLOAT,
+			.Format = DXGI_FORMAT_R32G32_UINT,  // one texel per probe, see packProbe in Skylighting.hlsli
 			.Usage = D3D11_USAGE_DEFAULT,
 			.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS,
 			.CPUAccessFlags = 0,
@@ -111,13 +207,13 @@ void Skylighting::SetupResources()
 
 		texProbeArray = new Texture3D(texDesc);
 		texProbeArray->CreateSRV(srvDesc);
-		texProbeArray->CreateUAV(uavDesc);
+		texProbeArray->CreateUAV(uavDesc);  // only cleared, typed UAV loads of R32G32 are optional
 
-		texDesc.Format = srvDesc.Format = uavDesc.Format = DXGI_FORMAT_R8_UINT;
+		texDesc.Depth = uavDesc.Texture3D.WSize = PROBE_UPDATE_SLICES;
+		texDesc.BindFlags = D3D11_BIND_UNORDERED_ACCESS;
 
-		texAccumFramesArray = new Texture3D(texDesc);
-		texAccumFramesArray->CreateSRV(srvDesc);
-		texAccumFramesArray->CreateUAV(uavDesc);
+		texProbeUpdate = new Texture3D(texDesc);
+		texProbeUpdate->CreateUAV(uavDesc);
 	}
 
 	{
@@ -137,6 +233,8 @@ void Skylighting::SetupResources()
 		DirectX::CreateDDSTextureFromFile(device, context, L"Data\\Shaders\\Skylighting\\SpatiotemporalBlueNoise\\stbn_vec3_2Dx1D_128x128x64.dds", nullptr, stbn_vec3_2Dx1D_128x128x64.put());
 	}
 
+	updateProbesCB = new ConstantBuffer(ConstantBufferDesc<UpdateProbesCB>(), true);
+
 	CompileComputeShaders();
 }
 
@@ -199,6 +297,14 @@ Skylighting::SkylightingCB Skylighting::GetCommonBufferData()
 	float3 cellIDDiff = prevCellID - cellID;
 	prevCellID = cellID;
 
+	validMargin[0] = (int)cellIDDiff.x;
+	validMargin[1] = (int)cellIDDiff.y;
+	validMargin[2] = (int)cellIDDiff.z;
+
+	arrayOrigin[0] = ((int)cellID.x - probeArrayDims[0] / 2) % probeArrayDims[0];
+	arrayOrigin[1] = ((int)cellID.y - probeArrayDims[1] / 2) % probeArrayDims[1];
+	arrayOrigin[2] = ((int)cellID.z - probeArrayDims[2] / 2) % probeArrayDims[2];
+
 	auto ambientDimmer = 1.0f;
 
 	auto ssgi = ScreenSpaceGI::GetSingleton();
@@ -210,10 +316,7 @@ Skylighting::SkylightingCB Skylighting::GetCommonBufferData()
 		.OcclusionViewProj = OcclusionTransform,
 		.OcclusionDir = OcclusionDir,
 		.PosOffset = cellOrigin - eyePos,
-		.ArrayOrigin = {
-			((int)cellID.x - probeArrayDims[0] / 2) % probeArrayDims[0],
-			((int)cellID.y - probeArrayDims[1] / 2) % probeArrayDims[1],
-			((int)cellID.z - probeArrayDims[2] / 2) % probeArrayDims[2] },
+		.ArrayOrigin = { arrayOrigin[0], arrayOrigin[1], arrayOrigin[2] },
 		.ValidMargin = { (int)cellIDDiff.x, (int)cellIDDiff.y, (int)cellIDDiff.z },
 		.MinDiffuseVisibility = settings.MinDiffuseVisibility * ambientDimmer,
 		.MinSpecularVisibility = settings.MinSpecularVisibility
@@ -240,27 +343,62 @@ void Skylighting::Prepass()
 
 	{
 		std::array<ID3D11ShaderResourceView*, 1> srvs = { texOcclusion->srv.get() };
-		std::array<ID3D11UnorderedAccessView*, 2> uavs = { texProbeArray->uav.get(), texAccumFramesArray->uav.get() };
 		std::array<ID3D11SamplerState*, 1> samplers = { comparisonSampler.get() };
 
-		// Update probe array
+		// Update probe array, the probe views are bound per dispatch in DispatchProbeUpdate
 		{
 			context->CSSetSamplers(0, (uint)samplers.size(), samplers.data());
 			context->CSSetShaderResources(0, (uint)srvs.size(), srvs.data());
-			context->CSSetUnorderedAccessViews(0, (uint)uavs.size(), uavs.data(), nullptr);
 			context->CSSetShader(probeUpdateCompute.get(), nullptr, 0);
-			context->Dispatch((probeArrayDims[0] + 7u) >> 3, (probeArrayDims[1] + 7u) >> 3, probeArrayDims[2]);
+
+			// Probes only accumulate on frames with a new occlusion sample, so each sample is weighted once
+			const bool newSample = occlusionUpdated;
+			occlusionUpdated = false;
+
+			if (newSample && (!settings.EnableIncrementalUpdates || fullUpdateFrames > 0)) {
+				const uint offset[3] = { 0, 0, 0 };
+				DispatchProbeUpdate(context, ProbeUpdateMode::Full, offset, probeArrayDims);
+				if (fullUpdateFrames > 0)
+					fullUpdateFrames--;
+			} else {
+				// Mandatory pass over the slabs scrolled in since last frame
+				for (uint axis = 0; axis < 3; axis++) {
+					int margin = std::clamp(validMargin[axis], -(int)probeArrayDims[axis], (int)probeArrayDims[axis]);
+					if (margin == 0)
+						continue;
+
+					uint offset[3] = { 0, 0, 0 };
+					uint size[3] = { probeArrayDims[0], probeArrayDims[1], probeArrayDims[2] };
+					offset[axis] = margin > 0 ? 0 : probeArrayDims[axis] + margin;
+					size[axis] = (uint)std::abs(margin);
+					DispatchProbeUpdate(context, newSample ? ProbeUpdateMode::Scrolled : ProbeUpdateMode::Invalidate, offset, size);
+				}
+
+				// Time sliced refinement over a rotating group of Z slices.
+				// Each group is kept for four samples so that it sees every quadrant of the occlusion map.
+				// A probe is only refined one sample in every groupCount, so each update is weighted as that many to converge as fast as a full update.
+				if (newSample) {
+					const uint sliceSize = probeArrayDims[0] * probeArrayDims[1];
+					const uint sliceCount = std::clamp((settings.ProbeUpdateBudget >> qualityLevel) / sliceSize, 1u, probeArrayDims[2]);
+					const uint groupCount = (probeArrayDims[2] + sliceCount - 1) / sliceCount;
+					const uint group = (frameCount / 4) % groupCount;
+
+					const uint offset[3] = { 0, 0, group * sliceCount };
+					const uint size[3] = { probeArrayDims[0], probeArrayDims[1], std::min(sliceCount, probeArrayDims[2] - offset[2]) };
+					DispatchProbeUpdate(context, ProbeUpdateMode::Refine, offset, size, groupCount);
+				}
+			}
 		}
 
 		// Reset
 		{
 			srvs.fill(nullptr);
-			uavs.fill(nullptr);
 			samplers.fill(nullptr);
 
+			ID3D11Buffer* buffer = nullptr;
+			context->CSSetConstantBuffers(0, 1, &buffer);
 			context->CSSetSamplers(0, (uint)samplers.size(), samplers.data());
 			context->CSSetShaderResources(0, (uint)srvs.size(), srvs.data());
-			context->CSSetUnorderedAccessViews(0, (uint)uavs.size(), uavs.data(), nullptr);
 			context->CSSetShader(nullptr, nullptr, 0);
 		}
 	}
@@ -268,7 +406,74 @@ void Skylighting::Prepass()
 	// Set PS shader resources
 	{
 		ID3D11ShaderResourceView* srvs[2] = { texProbeArray->srv.get(), stbn_vec3_2Dx1D_128x128x64.get() };
-		context->PSSetShaderResources(50, 2, srvs);
+		ExtendedRendererState::GetSingleton()->SetPSResources(50, 2, srvs);
+	}
+}
+
+void Skylighting::DispatchProbeUpdate(ID3D11DeviceContext* a_context, ProbeUpdateMode a_mode, const uint a_offset[3], const uint a_size[3], uint a_sampleWeight)
+{
+	// The update reads the array and writes texProbeUpdate, so large regions go a few slices at a time
+	for (uint slice = 0; slice < a_size[2]; slice += PROBE_UPDATE_SLICES) {
+		const uint offset[3] = { a_offset[0], a_offset[1], a_offset[2] + slice };
+		const uint size[3] = { a_size[0], a_size[1], std::min(PROBE_UPDATE_SLICES, a_size[2] - slice) };
+
+		UpdateProbesCB data{
+			.DispatchOffset = { offset[0], offset[1], offset[2] },
+			.UpdateMode = a_mode,
+			.DispatchSize = { size[0], size[1], size[2] },
+			.SampleWeight = a_sampleWeight
+		};
+		updateProbesCB->Update(data);
+		updateProbesCB->CSSet(a_context, 0);
+
+		ID3D11ShaderResourceView* srv = texProbeArray->srv.get();
+		ID3D11UnorderedAccessView* uav = texProbeUpdate->uav.get();
+		a_context->CSSetShaderResources(1, 1, &srv);
+		a_context->CSSetUnorderedAccessViews(0, 1, &uav, nullptr);
+
+		a_context->Dispatch((size[0] + 7u) >> 3, (size[1] + 7u) >> 3, size[2]);
+
+		srv = nullptr;
+		uav = nullptr;
+		a_context->CSSetShaderResources(1, 1, &srv);
+		a_context->CSSetUnorderedAccessViews(0, 1, &uav, nullptr);
+
+		CopyProbeUpdate(a_context, a_mode, offset, size);
+	}
+}
+
+void Skylighting::CopyProbeUpdate(ID3D11DeviceContext* a_context, ProbeUpdateMode a_mode, const uint a_offset[3], const uint a_size[3])
+{
+	// Probes sit at their dispatch position in texProbeUpdate.
+	// Cell space regions start at the array origin and wrap around the array, so each axis copies as one or two spans.
+	struct Span
+	{
+		uint src;
+		uint dst;
+		uint size;
+	};
+	Span spans[3][2];
+	uint spanCounts[3];
+
+	const bool cellSpace = a_mode == ProbeUpdateMode::Scrolled || a_mode == ProbeUpdateMode::Invalidate;
+	for (uint axis = 0; axis < 3; axis++) {
+		const uint start = cellSpace ? (a_offset[axis] + arrayOrigin[axis]) % probeArrayDims[axis] : a_offset[axis];
+		const uint head = std::min(a_size[axis], probeArrayDims[axis] - start);
+		spans[axis][0] = { 0, start, head };
+		spans[axis][1] = { head, 0, a_size[axis] - head };
+		spanCounts[axis] = head < a_size[axis] ? 2 : 1;
+	}
+
+	for (uint x = 0; x < spanCounts[0]; x++) {
+		for (uint y = 0; y < spanCounts[1]; y++) {
+			for (uint z = 0; z < spanCounts[2]; z++) {
+				const Span& sx = spans[0][x];
+				const Span& sy = spans[1][y];
+				const Span& sz = spans[2][z];
+				const D3D11_BOX box = { sx.src, sy.src, sz.src, sx.src + sx.size, sy.src + sy.size, sz.src + sz.size };
+				a_context->CopySubresourceRegion(texProbeArray->resource.get(), 0, sx.dst, sy.dst, sz.dst, texProbeUpdate->resource.get(), 0, &box);
+			}
+		}
 	}
 }
 
@@ -289,6 +494,9 @@ struct BSParticleShaderRainEmitter
 	char _pad_8[4056];
 };
 
+// Only used to receive the occlusion projection, so it is kept around instead of allocated per render
+static BSParticleShaderRainEmitter occlusionRainEmitter{};
+
 enum class ShaderTechnique
 {
 	// Sky
@@ -511,13 +719,25 @@ void Skylighting::RenderOcclusion()
 				state->EndPerfEvent();
 			}
 
-			{
+			auto eyePosNI = Util::GetEyePosition(0);
+			float3 eyePos = { eyePosNI.x, eyePosNI.y, eyePosNI.z };
+
+			// Every render is a whole extra geometry pass, only do it when the interval elapsed, the camera moved or after a reset
+			framesSinceOcclusion++;
+			bool renderOcclusion = queuedResetSkylighting ||
+			                       framesSinceOcclusion >= (settings.OcclusionUpdateInterval << qualityLevel) ||
+			                       (eyePos - lastOcclusionPosition).Length() > settings.OcclusionUpdateDistance;
+
+			if (renderOcclusion) {
 				state->BeginPerfEvent("Skylighting Mask");
 
 				if (queuedResetSkylighting)
 					ResetSkylighting();
 
 				frameCount++;
+				framesSinceOcclusion = 0;
+				lastOcclusionPosition = eyePos;
+				occlusionUpdated = true;
 
 				auto& precipitation = renderer->GetDepthStencilData().depthStencils[RE::RENDER_TARGETS_DEPTHSTENCIL::kPRECIPITATION_OCCLUSION_MAP];
 				RE::BSGraphics::DepthStencilData precipitationCopy = precipitation;
@@ -570,17 +790,15 @@ void Skylighting::RenderOcclusion()
 				precip->SetupMask();
 				precip->SetupMask();  // Calling setup twice fixes an issue when it is raining
 
-				BSParticleShaderRainEmitter* rain = new BSParticleShaderRainEmitter;
+				auto rain = reinterpret_cast<RE::BSParticleShaderRainEmitter*>(&occlusionRainEmitter);
 				{
 					TracyD3D11Zone(state->tracyCtx, "Skylighting - Render Height Map");
-					precip->RenderMask((RE::BSParticleShaderRainEmitter*)rain);
+					precip->RenderMask(rain);
 				}
 				inOcclusion = false;
 
 				OcclusionDir = -float4{ PrecipitationShaderDirectionF.x, PrecipitationShaderDirectionF.y, PrecipitationShaderDirectionF.z, 0 };
-				OcclusionTransform = ((RE::BSParticleShaderRainEmitter*)rain)->occlusionProjection;
-
-				delete rain;
+				OcclusionTransform = rain->occlusionProjection;
 
 				PrecipitationShaderCubeSize = originalPrecipitationShaderCubeSize;
 				precip->lastCubeSize = originaLastCubeSize;
@@ -30,6 +30,10 @@ struct Skylighting : Feature
 	virtual void ClearShaderCache() override;
 	void CompileComputeShaders();
 
+	// Each level halves the probe refinement budget and the occlusion map rate
+	virtual uint GetQualityLevelCount() override { return 3; }
+	virtual void SetQualityLevel(uint a_level) override { qualityLevel = a_level; }
+
 	virtual void Prepass() override;
 
 	virtual void PostPostLoad() override;
@@ -42,6 +46,10 @@ struct Skylighting : Feature
 		float MinDiffuseVisibility = 0.1f;
 		float MinSpecularVisibility = 0.01f;
 		float SSGIAmbientDimmer = 1.0f;
+		bool EnableIncrementalUpdates = true;
+		uint ProbeUpdateBudget = 256 * 256 * 16;  // probes refined per frame
+		uint OcclusionUpdateInterval = 2;         // frames between occlusion map renders
+		float OcclusionUpdateDistance = 128.0f;   // camera movement which forces an occlusion map render
 	} settings;
 
 	struct SkylightingCB
@@ -63,17 +71,37 @@ struct Skylighting : Feature
 
 	SkylightingCB GetCommonBufferData();
 
+	enum class ProbeUpdateMode : uint
+	{
+		Full,      // every probe
+		Scrolled,  // only probes newly scrolled into the array, DispatchOffset is in cell space
+		Refine,    // only previously valid probes, DispatchOffset is in array space
+		Invalidate  // like Scrolled, but resets the probes without taking a sample
+	};
+
+	struct UpdateProbesCB
+	{
+		uint DispatchOffset[3];
+		ProbeUpdateMode UpdateMode;
+		uint DispatchSize[3];
+		uint SampleWeight;  // occlusion samples each probe update stands for
+	};
+	static_assert(sizeof(UpdateProbesCB) % 16 == 0);
+
+	ConstantBuffer* updateProbesCB = nullptr;
+
 	winrt::com_ptr<ID3D11SamplerState> comparisonSampler = nullptr;
 
 	Texture2D* texOcclusion = nullptr;
-	Texture3D* texProbeArray = nullptr;
-	Texture3D* texAccumFramesArray = nullptr;
+	Texture3D* texProbeArray = nullptr;   // packed SH and accumulated frame count, see Skylighting.hlsli
+	Texture3D* texProbeUpdate = nullptr;  // probes written by one update dispatch, copied back into texProbeArray
 
 	winrt::com_ptr<ID3D11ComputeShader> probeUpdateCompute = nullptr;
 	winrt::com_ptr<ID3D11ShaderResourceView> stbn_vec3_2Dx1D_128x128x64;
 
 	// misc parameters
 	uint probeArrayDims[3] = { 256, 256, 128 };
+	static constexpr uint PROBE_UPDATE_SLICES = 16;  // Z slices per update dispatch, the depth of texProbeUpdate
 	float occlusionDistance = 4096.f * 2.5f;  // 5 ugrids
 
 	// cached variables
@@ -82,6 +110,16 @@ struct Skylighting : Feature
 	REX::W32::XMFLOAT4X4 OcclusionTransform;
 	float4 OcclusionDir;
 	uint frameCount = 0;
+	uint fullUpdateFrames = 0;
+	bool occlusionUpdated = false;  // a new occlusion sample was rendered since the last probe update
+	uint framesSinceOcclusion = 0;
+	float3 lastOcclusionPosition = { 0, 0, 0 };
+	uint qualityLevel = 0;
+	int validMargin[3] = { 0, 0, 0 };
+	uint arrayOrigin[3] = { 0, 0, 0 };
+
+	void DispatchProbeUpdate(ID3D11DeviceContext* a_context, ProbeUpdateMode a_mode, const uint a_offset[3], const uint a_size[3], uint a_sampleWeight = 1);
+	void CopyProbeUpdate(ID3D11DeviceContext* a_context, ProbeUpdateMode a_mode, const uint a_offset[3], const uint a_size[3]);
 
 	void ResetSkylighting();
 
@@ -5,6 +5,7 @@
 #include "Features/TerrainBlending.h"
 #include "ShaderCache.h"
 #include "State.h"
+#include "TexturePool.h"
 #include "Util.h"
 #include "VariableCache.h"
 
@@ -194,17 +195,54 @@ void SubsurfaceScattering::DrawSSS()
 		auto depth = renderer->GetDepthStencilData().depthStencils[RE::RENDER_TARGETS_DEPTHSTENCIL::kPOST_ZPREPASS_COPY];
 		auto mask = renderer->GetRuntimeData().renderTargets[MASKS];
 
-		ID3D11UnorderedAccessView* uav = blurHorizontalTemp->uav.get();
-		context->CSSetUnorderedAccessViews(0, 1, &uav, nullptr);
-
 		auto terrainBlending = TerrainBlending::GetSingleton();
 
-		ID3D11ShaderResourceView* views[3];
+		ID3D11ShaderResourceView* views[4];
 		views[0] = main.SRV;
 		views[1] = terrainBlending->loaded ? terrainBlending->blendedDepthTexture16->srv.get() : depth.depthSRV,
 		views[2] = mask.SRV;
+		views[3] = nullptr;
+
+		context->CSSetShaderResources(0, 4, views);
+
+		// Classify tiles
+		{
+			TracyD3D11Zone(State::GetSingleton()->tracyCtx, "Subsurface Scattering - Classify");
+
+			static constexpr uint clearMask[4] = { 0, 0, 0, 0 };
+			context->ClearUnorderedAccessViewUint(tileMask->uav.get(), clearMask);
+			context->ClearUnorderedAccessViewUint(tileArgs->uav.get(), clearMask);
+
+			static constexpr uint resetCount = 0;
+			static constexpr D3D11_BOX countBox = { 0, 0, 0, sizeof(uint), 1, 1 };
+			context->UpdateSubresource(tileList->resource.get(), 0, &countBox, &resetCount, 0, 0);
+
+			ID3D11UnorderedAccessView* uavs[3] = { tileList->uav.get(), tileArgs->uav.get(), tileMask->uav.get() };
+			context->CSSetUnorderedAccessViews(0, 3, uavs, nullptr);
+
+			context->CSSetShader(GetComputeShaderTileClassify(), nullptr, 0);
+			context->Dispatch(dispatchCount.x, dispatchCount.y, 1);
 
-		context->CSSetShaderResources(0, 3, views);
+			context->CSSetShader(GetComputeShaderTileCompact(), nullptr, 0);
+			context->Dispatch((dispatchCount.x + 7) >> 3, (dispatchCount.y + 7) >> 3, 1);
+
+			context->CSSetShader(GetComputeShaderTileArgs(), nullptr, 0);
+			context->Dispatch(1, 1, 1);
+
+			uavs[0] = nullptr;
+			uavs[1] = nullptr;
+			uavs[2] = nullptr;
+			context->CSSetUnorderedAccessViews(0, 3, uavs, nullptr);
+		}
+
+		TexturePool::Pass horizontalPass;
+		auto blurHorizontalTemp = horizontalPass.Write(blurHorizontalTempDesc);
+
+		ID3D11UnorderedAccessView* uav = blurHorizontalTemp->uav.get();
+		context->CSSetUnorderedAccessViews(0, 1, &uav, nullptr);
+
+		views[3] = tileList->srv.get();
+		context->CSSetShaderResources(3, 1, &views[3]);
 
 		// Horizontal pass to temporary texture
 		{
@@ -213,7 +251,7 @@ void SubsurfaceScattering::DrawSSS()
 			auto shader = GetComputeShaderHorizontalBlur();
 			context->CSSetShader(shader, nullptr, 0);
 
-			context->Dispatch(dispatchCount.x, dispatchCount.y, 1);
+			context->DispatchIndirect(tileArgs->resource.get(), 0);
 		}
 
 		uav = nullptr;
@@ -223,7 +261,8 @@ void SubsurfaceScattering::DrawSSS()
 		{
 			TracyD3D11Zone(State::GetSingleton()->tracyCtx, "Subsurface Scattering - Vertical");
 
-			views[0] = blurHorizontalTemp->srv.get();
+			TexturePool::Pass verticalPass;
+			views[0] = verticalPass.ReadLast(blurHorizontalTemp)->srv.get();
 			context->CSSetShaderResources(0, 1, views);
 
 			ID3D11UnorderedAccessView* uavs[1] = { main.UAV };
@@ -232,15 +271,15 @@ void SubsurfaceScattering::DrawSSS()
 			auto shader = GetComputeShaderVerticalBlur();
 			context->CSSetShader(shader, nullptr, 0);
 
-			context->Dispatch(dispatchCount.x, dispatchCount.y, 1);
+			context->DispatchIndirect(tileArgs->resource.get(), 0);
 		}
 	}
 
 	ID3D11Buffer* buffer = nullptr;
 	context->CSSetConstantBuffers(1, 1, &buffer);
 
-	ID3D11ShaderResourceView* views[3]{ nullptr, nullptr, nullptr };
-	context->CSSetShaderResources(0, 3, views);
+	ID3D11ShaderResourceView* views[4]{ nullptr, nullptr, nullptr, nullptr };
+	context->CSSetShaderResources(0, 4, views);
 
 	ID3D11UnorderedAccessView* uavs[1]{ nullptr };
 	context->CSSetUnorderedAccessViews(0, 1, uavs, nullptr);
@@ -260,20 +299,71 @@ void SubsurfaceScattering::SetupResources()
 	{
 		auto main = renderer->GetRuntimeData().renderTargets[RE::RENDER_TARGETS::kMAIN];
 
-		D3D11_TEXTURE2D_DESC texDesc{};
-		main.texture->GetDesc(&texDesc);
-
-		texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
+		main.texture->GetDesc(&blurHorizontalTempDesc);
+		blurHorizontalTempDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
+	}
 
-		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-		main.SRV->GetDesc(&srvDesc);
+	{
+		auto maxTiles = Util::GetScreenDispatchCount(false);
+		uint numTiles = maxTiles.x * maxTiles.y + 1;  // leading tile count
+
+		tileList = new Buffer(StructuredBufferDesc<uint>(numTiles));
+
+		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc{};
+		srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+		srvDesc.Buffer.FirstElement = 0;
+		srvDesc.Buffer.NumElements = numTiles;
+		tileList->CreateSRV(srvDesc);
+
+		D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc{};
+		uavDesc.Format = DXGI_FORMAT_UNKNOWN;
+		uavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+		uavDesc.Buffer.FirstElement = 0;
+		uavDesc.Buffer.NumElements = numTiles;
+		tileList->CreateUAV(uavDesc);
+	}
 
-		D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
-		main.UAV->GetDesc(&uavDesc);
+	{
+		D3D11_BUFFER_DESC argsDesc{};
+		argsDesc.Usage = D3D11_USAGE_DEFAULT;
+		argsDesc.BindFlags = D3D11_BIND_UNORDERED_ACCESS;
+		argsDesc.MiscFlags = D3D11_RESOURCE_MISC_DRAWINDIRECT_ARGS;
+		argsDesc.ByteWidth = sizeof(uint) * 3;
+
+		tileArgs = new Buffer(argsDesc);
+
+		D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc{};
+		uavDesc.Format = DXGI_FORMAT_R32_UINT;
+		uavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+		uavDesc.Buffer.FirstElement = 0;
+		uavDesc.Buffer.NumElements = 3;
+		tileArgs->CreateUAV(uavDesc);
+	}
 
-		blurHorizontalTemp = new Texture2D(texDesc);
-		blurHorizontalTemp->CreateSRV(srvDesc);
-		blurHorizontalTemp->CreateUAV(uavDesc);
+	{
+		auto maxTiles = Util::GetScreenDispatchCount(false);
+
+		D3D11_TEXTURE2D_DESC texDesc{
+			.Width = maxTiles.x,
+			.Height = maxTiles.y,
+			.MipLevels = 1,
+			.ArraySize = 1,
+			.Format = DXGI_FORMAT_R32_UINT,  // typed UAV loads are only guaranteed for 32-bit formats
+			.SampleDesc = { 1, 0 },
+			.Usage = D3D11_USAGE_DEFAULT,
+			.BindFlags = D3D11_BIND_UNORDERED_ACCESS,
+			.CPUAccessFlags = 0,
+			.MiscFlags = 0
+		};
+		D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {
+			.Format = texDesc.Format,
+			.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2D,
+			.Texture2D = { .MipSlice = 0 }
+		};
+
+		tileMask = new Texture2D(texDesc);
+		tileMask->CreateUAV(uavDesc);
 	}
 }
 
@@ -306,6 +396,18 @@ void SubsurfaceScattering::SaveSettings(json& o_json)
 
 void SubsurfaceScattering::ClearShaderCache()
 {
+	if (tileClassifyCS) {
+		tileClassifyCS->Release();
+		tileClassifyCS = nullptr;
+	}
+	if (tileCompactCS) {
+		tileCompactCS->Release();
+		tileCompactCS = nullptr;
+	}
+	if (tileArgsCS) {
+		tileArgsCS->Release();
+		tileArgsCS = nullptr;
+	}
 	if (horizontalSSBlur) {
 		horizontalSSBlur->Release();
 		horizontalSSBlur = nullptr;
@@ -316,6 +418,33 @@ void SubsurfaceScattering::ClearShaderCache()
 	}
 }
 
+ID3D11ComputeShader* SubsurfaceScattering::GetComputeShaderTileClassify()
+{
+	if (!tileClassifyCS) {
+		logger::debug("Compiling tileClassifyCS");
+		tileClassifyCS = (ID3D11ComputeShader*)Util::CompileShader(L"Data\\Shaders\\SubsurfaceScattering\\TileClassifyCS.hlsl", {}, "cs_5_0");
+	}
+	return tileClassifyCS;
+}
+
+ID3D11ComputeShader* SubsurfaceScattering::GetComputeShaderTileCompact()
+{
+	if (!tileCompactCS) {
+		logger::debug("Compiling tileCompactCS");
+		tileCompactCS = (ID3D11ComputeShader*)Util::CompileShader(L"Data\\Shaders\\SubsurfaceScattering\\TileClassifyCS.hlsl", { { "COMPACT", "" } }, "cs_5_0");
+	}
+	return tileCompactCS;
+}
+
+ID3D11ComputeShader* SubsurfaceScattering::GetComputeShaderTileArgs()
+{
+	if (!tileArgsCS) {
+		logger::debug("Compiling tileArgsCS");
+		tileArgsCS = (ID3D11ComputeShader*)Util::CompileShader(L"Data\\Shaders\\SubsurfaceScattering\\TileClassifyCS.hlsl", { { "ARGS", "" } }, "cs_5_0");
+	}
+	return tileArgsCS;
+}
+
 ID3D11ComputeShader* SubsurfaceScattering::GetComputeShaderHorizontalBlur()
 {
 	if (!horizontalSSBlur) {
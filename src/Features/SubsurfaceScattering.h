@@ -53,8 +53,17 @@ public:
 	bool updateKernels = true;
 	bool validMaterials = false;
 
-	Texture2D* blurHorizontalTemp = nullptr;
+	// Output of the horizontal blur, taken from the texture pool for the two blur passes
+	D3D11_TEXTURE2D_DESC blurHorizontalTempDesc{};
 
+	// 8x8 tiles within the kernel radius of scattering pixels, the blurs are dispatched indirectly over these only
+	Buffer* tileList = nullptr;
+	Buffer* tileArgs = nullptr;
+	Texture2D* tileMask = nullptr;
+
+	ID3D11ComputeShader* tileClassifyCS = nullptr;
+	ID3D11ComputeShader* tileCompactCS = nullptr;
+	ID3D11ComputeShader* tileArgsCS = nullptr;
 	ID3D11ComputeShader* horizontalSSBlur = nullptr;
 	ID3D11ComputeShader* verticalSSBlur = nullptr;
 	RE::BGSKeyword* isBeastRaceKeyword = nullptr;
@@ -81,6 +90,9 @@ public:
 	virtual void SaveSettings(json& o_json) override;
 
 	virtual void ClearShaderCache() override;
+	ID3D11ComputeShader* GetComputeShaderTileClassify();
+	ID3D11ComputeShader* GetComputeShaderTileCompact();
+	ID3D11ComputeShader* GetComputeShaderTileArgs();
 	ID3D11ComputeShader* GetComputeShaderHorizontalBlur();
 	ID3D11ComputeShader* GetComputeShaderVerticalBlur();
 
@@ -1,5 +1,6 @@
 #include "TerrainBlending.h"
 
+#include "ExtendedRendererState.h"
 #include "State.h"
 #include "Util.h"
 
@@ -289,7 +290,6 @@ void TerrainBlending::RenderTerrain()
 	renderTerrainWorld = true;
 
 	auto renderer = VariableCache::GetSingleton()->renderer;
-	auto context = VariableCache::GetSingleton()->context;
 	auto shadowState = VariableCache::GetSingleton()->shadowState;
 	auto stateUpdateFlags = VariableCache::GetSingleton()->stateUpdateFlags;
 
@@ -306,8 +306,7 @@ void TerrainBlending::RenderTerrain()
 	stateUpdateFlags->set(RE::BSGraphics::ShaderFlags::DIRTY_DEPTH_MODE);
 
 	// Used to get the distance of the surface to the lowest depth
-	auto view = terrainDepth.depthSRV;
-	context->PSSetShaderResources(55, 1, &view);
+	ExtendedRendererState::GetSingleton()->SetPSResource(55, terrainDepth.depthSRV);
 
 	for (auto& renderPass : renderPasses)
 		TerrainBlending::Hooks::BSBatchRenderer__RenderPassImmediately::func(renderPass.a_pass, renderPass.a_technique, renderPass.a_alphaTest, renderPass.a_renderFlags);
@@ -2,6 +2,7 @@
 #include "Menu.h"
 
 #include "Deferred.h"
+#include "ExtendedRendererState.h"
 #include "State.h"
 #include "Util.h"
 
@@ -10,7 +11,8 @@
 
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(
 	TerrainShadows::Settings,
-	EnableTerrainShadow)
+	EnableTerrainShadow,
+	UpdateAngle)
 
 void TerrainShadows::LoadSettings(json& o_json)
 {
@@ -26,6 +28,12 @@ void TerrainShadows::DrawSettings()
 {
 	ImGui::Checkbox("Enable Terrain Shadow", &settings.EnableTerrainShadow);
 
+	ImGui::SliderFloat("Update Angle", &settings.UpdateAngle, 0.25f, 5.0f, "%.2f deg", ImGuiSliderFlags_AlwaysClamp);
+	if (auto _tt = Util::HoverTooltipWrapper())
+		ImGui::Text(
+			"How far the sun moves between the two shadow maps that are blended together.\n"
+			"Smaller angles are more accurate but update more often.");
+
 	if (ImGui::CollapsingHeader("Debug")) {
 		std::string curr_worldspace = "N/A";
 		std::string curr_worldspace_name = "N/A";
@@ -39,6 +47,8 @@ void TerrainShadows::DrawSettings()
 		}
 		ImGui::Text(fmt::format("Current worldspace: {} ({})", curr_worldspace, curr_worldspace_name).c_str());
 		ImGui::Text(fmt::format("Has height map: {}", heightmaps.contains(curr_worldspace)).c_str());
+		ImGui::Text(fmt::format("Loaded height map: {}", cachedHeightmap ? cachedHeightmap->worldspace : "N/A").c_str());
+		ImGui::Text(fmt::format("Pending height map: {}", pendingHeightmap ? pendingHeightmap->worldspace : "N/A").c_str());
 
 		ImGui::Separator();
 
@@ -52,12 +62,17 @@ void TerrainShadows::DrawSettings()
 		}
 		ImGui::Unindent();
 
+		ImGui::Text(fmt::format("Sweeping: {} ({}/{})", sweeping, shadowUpdateIdx, maxUpdates).c_str());
+		ImGui::Text(fmt::format("Shadow blend: {:.3f}", shadowBlend).c_str());
+		ImGui::Text(fmt::format("Sun speed: {:.5f} deg/frame", sunAngularSpeed * 180.f / RE::NI_PI).c_str());
+
 		if (ImGui::TreeNode("Buffer Viewer")) {
 			static float debugRescale = .1f;
 			ImGui::SliderFloat("View Resize", &debugRescale, 0.f, 1.f);
 
-			if (texShadowHeight) {
-				BUFFER_VIEWER_NODE_BULLET(texShadowHeight, debugRescale)
+			if (texShadowHeight[0]) {
+				BUFFER_VIEWER_NODE_BULLET(texShadowHeight[0], debugRescale)
+				BUFFER_VIEWER_NODE_BULLET(texShadowHeight[1], debugRescale)
 			}
 			ImGui::TreePop();
 		}
@@ -129,8 +144,10 @@ void TerrainShadows::ParseHeightmapPath(std::filesystem::path p, bool xlodgen_st
 		logger::debug("{} has unknown type ({})", filename.string(), splitstr[1]);
 }
 
-void TerrainShadows::SetupResources()
+void TerrainShadows::ScanHeightmaps()
 {
+	heightmaps.clear();
+
 	logger::debug("Listing xLODGen height maps...");
 	{
 		std::filesystem::path texture_dir{ L"Data\\textures\\Terrain\\" };
@@ -152,6 +169,105 @@ void TerrainShadows::SetupResources()
 		for (auto const& dir_entry : std::filesystem::directory_iterator{ texture_dir, ec })
 			ParseHeightmapPath(dir_entry.path(), false);
 	}
+}
+
+std::map<std::string, int64_t> TerrainShadows::GetHeightmapDirectories()
+{
+	// Adding or removing a file only changes the modification time of the directory holding it
+	std::map<std::string, int64_t> directories;
+	auto addDirectory = [&](const std::filesystem::path& a_path) {
+		std::error_code ec;
+		auto time = std::filesystem::last_write_time(a_path, ec);
+		directories[a_path.string()] = ec ? 0 : time.time_since_epoch().count();
+	};
+
+	std::filesystem::path terrain_dir{ L"Data\\textures\\Terrain\\" };
+	addDirectory(terrain_dir);
+
+	std::error_code ec;
+	for (auto const& dir_entry : std::filesystem::directory_iterator{ terrain_dir, ec })
+		if (dir_entry.is_directory(ec))
+			addDirectory(dir_entry.path());
+
+	addDirectory(L"Data\\textures\\heightmaps\\");
+
+	return directories;
+}
+
+bool TerrainShadows::LoadHeightmapIndex()
+{
+	std::ifstream file(heightmapIndexPath);
+	if (!file.is_open())
+		return false;
+
+	try {
+		json index;
+		file >> index;
+
+		if (index["Version"].get<uint>() != HEIGHTMAP_INDEX_VERSION ||
+			index["Directories"].get<std::map<std::string, int64_t>>() != GetHeightmapDirectories()) {
+			logger::info("Height map index is out of date");
+			return false;
+		}
+
+		heightmaps.clear();
+		for (auto& entry : index["Heightmaps"]) {
+			HeightMapMetadata metadata;
+			metadata.dir = std::filesystem::path(entry["Dir"].get<std::string>()).wstring();
+			metadata.filename = entry["Filename"].get<std::string>();
+			metadata.worldspace = entry["Worldspace"].get<std::string>();
+			metadata.pos0 = entry["Pos0"].get<float3>();
+			metadata.pos1 = entry["Pos1"].get<float3>();
+			metadata.zRange = entry["ZRange"].get<float2>();
+			heightmaps[metadata.worldspace] = metadata;
+		}
+	} catch (const std::exception& e) {
+		logger::warn("Failed to read height map index ({}) : {}", heightmapIndexPath, e.what());
+		heightmaps.clear();
+		return false;
+	}
+
+	logger::info("{} height maps loaded from index.", heightmaps.size());
+	return true;
+}
+
+void TerrainShadows::SaveHeightmapIndex()
+{
+	json index;
+	index["Version"] = HEIGHTMAP_INDEX_VERSION;
+	index["Directories"] = GetHeightmapDirectories();
+	index["Heightmaps"] = json::array();
+	for (auto& [worldspace, metadata] : heightmaps) {
+		index["Heightmaps"].push_back({
+			{ "Dir", std::filesystem::path(metadata.dir).string() },
+			{ "Filename", metadata.filename },
+			{ "Worldspace", metadata.worldspace },
+			{ "Pos0", metadata.pos0 },
+			{ "Pos1", metadata.pos1 },
+			{ "ZRange", metadata.zRange },
+		});
+	}
+
+	try {
+		std::filesystem::create_directories(std::filesystem::path(heightmapIndexPath).parent_path());
+
+		std::ofstream file(heightmapIndexPath);
+		if (!file.is_open()) {
+			logger::warn("Failed to open height map index for saving: {}", heightmapIndexPath);
+			return;
+		}
+		file << std::setw(4) << index;
+	} catch (const std::exception& e) {
+		logger::warn("Failed to write height map index ({}) : {}", heightmapIndexPath, e.what());
+	}
+}
+
+void TerrainShadows::SetupResources()
+{
+	if (!LoadHeightmapIndex()) {
+		ScanHeightmaps();
+		SaveHeightmapIndex();
+	}
 
 	logger::debug("Creating constant buffers...");
 	{
@@ -192,69 +308,115 @@ TerrainShadows::PerFrame TerrainShadows::GetCommonBufferData()
 		data.Scale = float3(1.f, 1.f, 1.f) / invScale;
 		data.Offset = -cachedHeightmap->pos0 * float2{ data.Scale.x, data.Scale.y };
 		data.ZRange = cachedHeightmap->zRange;
+		data.ShadowBlend = shadowBlend;
 	}
 
 	return data;
 }
 
-void TerrainShadows::LoadHeightmap()
+std::string TerrainShadows::GetCurrentWorldspace()
 {
-	auto tes = RE::TES::GetSingleton();
-	if (!tes)
-		return;
-	auto worldspace = tes->GetRuntimeData2().worldSpace;
-	if (!worldspace)
+	if (auto tes = RE::TES::GetSingleton())
+		if (auto worldspace = tes->GetRuntimeData2().worldSpace)
+			return worldspace->GetFormEditorID();
+	return {};
+}
+
+std::unique_ptr<Texture2D> TerrainShadows::CreateHeightmapTexture(std::filesystem::path a_path)
+{
+	auto& device = State::GetSingleton()->device;
+
+	DirectX::ScratchImage image;
+	try {
+		DX::ThrowIfFailed(LoadFromDDSFile(a_path.c_str(), DirectX::DDS_FLAGS_NONE, nullptr, image));
+	} catch (const DX::com_exception& e) {
+		logger::error("{}", e.what());
+		return nullptr;
+	}
+
+	ID3D11Resource* pResource = nullptr;
+	try {
+		DX::ThrowIfFailed(CreateTexture(device,
+			image.GetImages(), image.GetImageCount(),
+			image.GetMetadata(), &pResource));
+	} catch (const DX::com_exception& e) {
+		logger::error("{}", e.what());
+		return nullptr;
+	}
+
+	auto texture = std::make_unique<Texture2D>(reinterpret_cast<ID3D11Texture2D*>(pResource));
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {
+		.Format = texture->desc.Format,
+		.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D,
+		.Texture2D = {
+			.MostDetailedMip = 0,
+			.MipLevels = 1 }
+	};
+	texture->CreateSRV(srvDesc);
+
+	return texture;
+}
+
+void TerrainShadows::RequestHeightmap(const std::string& a_worldspace)
+{
+	if (!heightmaps.contains(a_worldspace))  // no height map for that, but we don't remove cache
 		return;
-	std::string worldspace_name = worldspace->GetFormEditorID();
-	if (!heightmaps.contains(worldspace_name))  // no height map for that, but we don't remove cache
+	if (cachedHeightmap && cachedHeightmap->worldspace == a_worldspace)  // already cached
 		return;
-	if (cachedHeightmap && cachedHeightmap->worldspace == worldspace_name)  // already cached
+	if (pendingHeightmap)  // one load at a time, a different worldspace is requested again once it finished
 		return;
 
-	auto& device = State::GetSingleton()->device;
+	logger::debug("Loading height map for {}...", a_worldspace);
 
-	logger::debug("Loading height map...");
-	{
-		auto& target_heightmap = heightmaps[worldspace_name];
+	auto& target_heightmap = heightmaps[a_worldspace];
+	std::filesystem::path path{ target_heightmap.dir };
+	path /= target_heightmap.filename;
 
-		DirectX::ScratchImage image;
-		try {
-			std::filesystem::path path{ target_heightmap.dir };
-			path /= target_heightmap.filename;
-
-			DX::ThrowIfFailed(LoadFromDDSFile(path.c_str(), DirectX::DDS_FLAGS_NONE, nullptr, image));
-		} catch (const DX::com_exception& e) {
-			logger::error("{}", e.what());
-			return;
-		}
+	pendingHeightmap = PendingHeightmap{
+		.worldspace = a_worldspace,
+		.texture = std::async(std::launch::async, [this, path]() {
+			Profiler::Scope scope(this);
+			return CreateHeightmapTexture(path);
+		})
+	};
+}
 
-		ID3D11Resource* pResource = nullptr;
-		try {
-			DX::ThrowIfFailed(CreateTexture(device,
-				image.GetImages(), image.GetImageCount(),
-				image.GetMetadata(), &pResource));
-		} catch (const DX::com_exception& e) {
-			logger::error("{}", e.what());
-			return;
+void TerrainShadows::LoadHeightmap()
+{
+	if (pendingHeightmap && pendingHeightmap->texture.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+		auto texture = pendingHeightmap->texture.get();
+		auto worldspace = std::move(pendingHeightmap->worldspace);
+		pendingHeightmap.reset();
+
+		// Swap texture and metadata together, the shadow texture is rebuilt for the new size
+		if (texture) {
+			texHeightMap = std::move(texture);
+			cachedHeightmap = &heightmaps[worldspace];
+
+			shadowUpdateIdx = 0;
+			needPrecompute = true;
 		}
+	}
 
-		texHeightMap.release();
-		texHeightMap = std::make_unique<Texture2D>(reinterpret_cast<ID3D11Texture2D*>(pResource));
+	auto worldspace = GetCurrentWorldspace();
+	if (!worldspace.empty())
+		RequestHeightmap(worldspace);
+}
 
-		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {
-			.Format = texHeightMap->desc.Format,
-			.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D,
-			.Texture2D = {
-				.MostDetailedMip = 0,
-				.MipLevels = 1 }
-		};
-		texHeightMap->CreateSRV(srvDesc);
+void TerrainShadows::DataLoaded()
+{
+	MenuOpenCloseEventHandler::Register();
+}
 
-		cachedHeightmap = &heightmaps[worldspace_name];
+void TerrainShadows::Reset()
+{
+	// Start reading the destination heightmap as soon as the loadscreen knows the worldspace
+	if (loadingScreenOpen) {
+		auto worldspace = GetCurrentWorldspace();
+		if (!worldspace.empty())
+			RequestHeightmap(worldspace);
 	}
-
-	shadowUpdateIdx = 0;
-	needPrecompute = true;
 }
 
 void TerrainShadows::Precompute()
@@ -262,10 +424,8 @@ void TerrainShadows::Precompute()
 	if (!cachedHeightmap)
 		return;
 
-	logger::info("Creating shadow texture...");
+	logger::info("Creating shadow textures...");
 	{
-		texShadowHeight.release();
-
 		D3D11_TEXTURE2D_DESC texDesc = {
 			.Width = texHeightMap->desc.Width,
 			.Height = texHeightMap->desc.Height,
@@ -289,88 +449,75 @@ void TerrainShadows::Precompute()
 			.Texture2D = { .MipSlice = 0 }
 		};
 
-		texShadowHeight = std::make_unique<Texture2D>(texDesc);
-		texShadowHeight->CreateSRV(srvDesc);
-		texShadowHeight->CreateUAV(uavDesc);
+		for (auto& tex : texShadowHeight) {
+			tex = std::make_unique<Texture2D>(texDesc);
+			tex->CreateSRV(srvDesc);
+			tex->CreateUAV(uavDesc);
+		}
 	}
 
 	needPrecompute = false;
+	needBurst = true;
 }
 
-void TerrainShadows::UpdateShadow()
+static float AngleBetween(const float3& a_dir0, const float3& a_dir1)
 {
-	if (!IsHeightMapReady())
-		return;
+	return std::acos(std::clamp(a_dir0.Dot(a_dir1), -1.f, 1.f));
+}
 
+void TerrainShadows::SetupSweep(float3 a_dirLightDir)
+{
 	// don't forget to change NTHREADS in shader!
 	constexpr uint updateLength = 128u;
 	constexpr uint logUpdateLength = std::bit_width(128u) - 1;  // integer log2, https://stackoverflow.com/questions/994593/how-to-do-an-integer-log2-in-c
 
-	auto& context = State::GetSingleton()->context;
-	auto accumulator = RE::BSGraphics::BSShaderAccumulator::GetCurrentAccumulator();
-	auto sunLight = skyrim_cast<RE::NiDirectionalLight*>(accumulator->GetRuntimeData().activeShadowSceneNode->GetRuntimeData().sunLight->light.get());
-	if (!sunLight)
-		return;
-
-	ZoneScoped;
-	TracyD3D11Zone(State::GetSingleton()->tracyCtx, "Terrain Occlusion - Update Shadows");
-
-	/* ---- UPDATE CB ---- */
 	uint width = texHeightMap->desc.Width;
 	uint height = texHeightMap->desc.Height;
 
-	// only update direction at the start of each cycle
-	static uint edgePxCoord;
-	static int signDir;
-	static uint maxUpdates;
-	if (shadowUpdateIdx == 0) {
-		auto direction = sunLight->GetWorldDirection();
-		float3 dirLightDir = { direction.x, direction.y, direction.z };
-		if (dirLightDir.z > 0)
-			dirLightDir = -dirLightDir;
-
-		// in UV
-		float3 invScale = cachedHeightmap->pos1 - cachedHeightmap->pos0;
-		invScale.z = cachedHeightmap->zRange.y - cachedHeightmap->zRange.x;
-		float3 dirLightPxDir = dirLightDir / invScale;
-		dirLightPxDir.x *= width;
-		dirLightPxDir.y *= height;
-
-		float stepMult;
-		if (abs(dirLightPxDir.x) >= abs(dirLightPxDir.y)) {
-			stepMult = 1.f / abs(dirLightPxDir.x);
-			edgePxCoord = dirLightPxDir.x > 0 ? 0 : (width - 1);
-			signDir = dirLightPxDir.x > 0 ? 1 : -1;
-			maxUpdates = (width + updateLength - 1) >> logUpdateLength;
-		} else {
-			stepMult = 1.f / abs(dirLightPxDir.y);
-			edgePxCoord = dirLightPxDir.y > 0 ? 0 : height - 1;
-			signDir = dirLightPxDir.y > 0 ? 1 : -1;
-			maxUpdates = (height + updateLength - 1) >> logUpdateLength;
-		}
-		dirLightPxDir *= stepMult;
+	// in UV
+	float3 invScale = cachedHeightmap->pos1 - cachedHeightmap->pos0;
+	invScale.z = cachedHeightmap->zRange.y - cachedHeightmap->zRange.x;
+	float3 dirLightPxDir = a_dirLightDir / invScale;
+	dirLightPxDir.x *= width;
+	dirLightPxDir.y *= height;
+
+	float stepMult;
+	if (abs(dirLightPxDir.x) >= abs(dirLightPxDir.y)) {
+		stepMult = 1.f / abs(dirLightPxDir.x);
+		edgePxCoord = dirLightPxDir.x > 0 ? 0 : (width - 1);
+		signDir = dirLightPxDir.x > 0 ? 1 : -1;
+		maxUpdates = (width + updateLength - 1) >> logUpdateLength;
+	} else {
+		stepMult = 1.f / abs(dirLightPxDir.y);
+		edgePxCoord = dirLightPxDir.y > 0 ? 0 : height - 1;
+		signDir = dirLightPxDir.y > 0 ? 1 : -1;
+		maxUpdates = (height + updateLength - 1) >> logUpdateLength;
+	}
+	dirLightPxDir *= stepMult;
 
-		shadowUpdateCBData.LightPxDir = { dirLightPxDir.x, dirLightPxDir.y };
+	shadowUpdateCBData.LightPxDir = { dirLightPxDir.x, dirLightPxDir.y };
 
-		// soft shadow angles
-		float lenUV = float2{ dirLightDir.x, dirLightDir.y }.Length();
-		float dirLightAngle = atan2(-dirLightDir.z, lenUV);
-		float shadowSofteningRadiusAngle = 4.f * RE::NI_PI / 180.f;
-		float upperAngle = std::max(0.f, dirLightAngle - shadowSofteningRadiusAngle);
-		float lowerAngle = std::min(RE::NI_HALF_PI - 1e-2f, dirLightAngle + shadowSofteningRadiusAngle);
+	// soft shadow angles
+	float lenUV = float2{ a_dirLightDir.x, a_dirLightDir.y }.Length();
+	float dirLightAngle = atan2(-a_dirLightDir.z, lenUV);
+	float shadowSofteningRadiusAngle = 4.f * RE::NI_PI / 180.f;
+	float upperAngle = std::max(0.f, dirLightAngle - shadowSofteningRadiusAngle);
+	float lowerAngle = std::min(RE::NI_HALF_PI - 1e-2f, dirLightAngle + shadowSofteningRadiusAngle);
 
-		shadowUpdateCBData.LightDeltaZ = -(lenUV / invScale.z * stepMult) * float2{ std::tan(upperAngle), std::tan(lowerAngle) };
-	}
-
-	shadowUpdateCBData.StartPxCoord = edgePxCoord + signDir * shadowUpdateIdx * updateLength;
-	shadowUpdateCBData.PxSize = { 1.f / texHeightMap->desc.Width, 1.f / texHeightMap->desc.Height };
+	shadowUpdateCBData.LightDeltaZ = -(lenUV / invScale.z * stepMult) * float2{ std::tan(upperAngle), std::tan(lowerAngle) };
 
+	shadowUpdateCBData.PxSize = { 1.f / width, 1.f / height };
 	shadowUpdateCBData.PosRange = { cachedHeightmap->pos0.z, cachedHeightmap->pos1.z };
 	shadowUpdateCBData.ZRange = cachedHeightmap->zRange;
 
-	shadowUpdateCB->Update(shadowUpdateCBData);
+	shadowUpdateIdx = 0;
+}
+
+void TerrainShadows::DispatchSweep(Texture2D* a_target, uint a_count)
+{
+	constexpr uint updateLength = 128u;
 
-	shadowUpdateIdx = (shadowUpdateIdx + 1) % maxUpdates;
+	auto& context = State::GetSingleton()->context;
 
 	/* ---- BACKUP ---- */
 	struct ShaderState
@@ -383,14 +530,22 @@ void TerrainShadows::UpdateShadow()
 
 	/* ---- DISPATCH ---- */
 	newer.srvs[0] = texHeightMap->srv.get();
-	newer.uavs[0] = texShadowHeight->uav.get();
+	newer.uavs[0] = a_target->uav.get();
 	newer.buffer = shadowUpdateCB->CB();
 
 	context->CSSetShaderResources(0, ARRAYSIZE(newer.srvs), newer.srvs);
 	context->CSSetUnorderedAccessViews(0, ARRAYSIZE(newer.uavs), newer.uavs, nullptr);
 	context->CSSetConstantBuffers(0, 1, &newer.buffer);
 	context->CSSetShader(shadowUpdateProgram.get(), nullptr, 0);
-	context->Dispatch(abs(shadowUpdateCBData.LightPxDir.x) >= abs(shadowUpdateCBData.LightPxDir.y) ? height : width, 1, 1);
+
+	uint width = texHeightMap->desc.Width;
+	uint height = texHeightMap->desc.Height;
+	for (uint i = 0; i < a_count && shadowUpdateIdx < maxUpdates; i++, shadowUpdateIdx++) {
+		shadowUpdateCBData.StartPxCoord = edgePxCoord + signDir * shadowUpdateIdx * updateLength;
+		shadowUpdateCB->Update(shadowUpdateCBData);
+
+		context->Dispatch(abs(shadowUpdateCBData.LightPxDir.x) >= abs(shadowUpdateCBData.LightPxDir.y) ? height : width, 1, 1);
+	}
 
 	/* ---- RESTORE ---- */
 	context->CSSetShaderResources(0, ARRAYSIZE(old.srvs), old.srvs);
@@ -399,6 +554,96 @@ void TerrainShadows::UpdateShadow()
 	context->CSSetConstantBuffers(0, 1, &old.buffer);
 }
 
+void TerrainShadows::UpdateShadow()
+{
+	if (!IsHeightMapReady())
+		return;
+
+	auto& context = State::GetSingleton()->context;
+	auto accumulator = RE::BSGraphics::BSShaderAccumulator::GetCurrentAccumulator();
+	auto sunLight = skyrim_cast<RE::NiDirectionalLight*>(accumulator->GetRuntimeData().activeShadowSceneNode->GetRuntimeData().sunLight->light.get());
+	if (!sunLight)
+		return;
+
+	ZoneScoped;
+	TracyD3D11Zone(State::GetSingleton()->tracyCtx, "Terrain Occlusion - Update Shadows");
+
+	auto direction = sunLight->GetWorldDirection();
+	float3 sunDir = { direction.x, direction.y, direction.z };
+	if (sunDir.z > 0)
+		sunDir = -sunDir;
+	sunDir.Normalize();
+
+	float frameDelta = AngleBetween(sunDir, lastSunDir);
+	lastSunDir = sunDir;
+
+	uint older = !newerShadowMap;
+
+	// Recompute the whole map at once when the sun jumped, both maps then hold the same direction
+	if (needBurst || frameDelta > BURST_ANGLE * RE::NI_PI / 180.f) {
+		SetupSweep(sunDir);
+		DispatchSweep(texShadowHeight[newerShadowMap].get(), maxUpdates);
+		context->CopyResource(texShadowHeight[older]->resource.get(), texShadowHeight[newerShadowMap]->resource.get());
+
+		shadowDirs[0] = shadowDirs[1] = sunDir;
+		sunAngularSpeed = 0.f;
+		shadowBlend = 1.f;
+		sweeping = false;
+		needBurst = false;
+		return;
+	}
+
+	sunAngularSpeed = std::lerp(sunAngularSpeed, frameDelta, 0.05f);
+
+	// How far the sun has moved from the older map to the newer one
+	auto getBlend = [&](uint a_older) {
+		float span = AngleBetween(shadowDirs[a_older], shadowDirs[!a_older]);
+		return span > 1e-5f ? std::clamp(AngleBetween(shadowDirs[a_older], sunDir) / span, 0.f, 1.f) : 1.f;
+	};
+	shadowBlend = getBlend(older);
+
+	float updateAngle = settings.UpdateAngle * RE::NI_PI / 180.f;
+
+	if (!sweeping) {
+		// Nearly static sun, or it has not reached the newer map yet
+		float lead = AngleBetween(shadowDirs[newerShadowMap], sunDir);
+		if (shadowBlend < 1.f || lead < updateAngle * 0.05f)
+			return;
+
+		// Aim the next map ahead of the sun along its current motion
+		float3 motion = sunDir - shadowDirs[newerShadowMap];
+		motion -= sunDir * motion.Dot(sunDir);
+		motion.Normalize();
+		sweepDir = sunDir + motion * std::tan(updateAngle);
+		sweepDir.Normalize();
+
+		SetupSweep(sweepDir);
+		sweepBudget = 0.f;
+		sweeping = true;
+	}
+
+	// The older map is being overwritten
+	shadowBlend = 1.f;
+
+	float framesToTarget = updateAngle / std::max(sunAngularSpeed, 1e-7f);
+	sweepBudget += std::min((float)maxUpdates, maxUpdates * SWEEP_SPEEDUP / framesToTarget);
+	uint count = (uint)sweepBudget;
+	if (count == 0)
+		return;
+	sweepBudget -= count;
+
+	DispatchSweep(texShadowHeight[older].get(), count);
+
+	if (shadowUpdateIdx >= maxUpdates) {
+		shadowDirs[older] = sweepDir;
+		newerShadowMap = older;
+		sweeping = false;
+
+		// The finished map is aimed ahead of the sun, blend from the previous one this frame already
+		shadowBlend = getBlend(!newerShadowMap);
+	}
+}
+
 void TerrainShadows::EarlyPrepass()
 {
 	LoadHeightmap();
@@ -411,11 +656,13 @@ void TerrainShadows::EarlyPrepass()
 
 	UpdateShadow();
 
-	if (texShadowHeight) {
+	if (texShadowHeight[0]) {
 		auto context = State::GetSingleton()->context;
 
-		std::array<ID3D11ShaderResourceView*, 1> srvs = { texShadowHeight->srv.get() };
-		context->PSSetShaderResources(60, (uint)srvs.size(), srvs.data());
+		// While the next map is swept only the newer one is valid
+		auto olderSrv = texShadowHeight[sweeping ? newerShadowMap : !newerShadowMap]->srv.get();
+		std::array<ID3D11ShaderResourceView*, 2> srvs = { olderSrv, texShadowHeight[newerShadowMap]->srv.get() };
+		ExtendedRendererState::GetSingleton()->SetPSResources(60, (uint)srvs.size(), srvs.data());
 		context->CSSetShaderResources(60, (uint)srvs.size(), srvs.data());
 	}
 }
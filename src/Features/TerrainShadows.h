@@ -4,6 +4,7 @@
 #include "Feature.h"
 
 #include <filesystem>
+#include <future>
 
 struct TerrainShadows : public Feature
 {
@@ -21,11 +22,29 @@ struct TerrainShadows : public Feature
 	struct Settings
 	{
 		bool EnableTerrainShadow = true;
+		float UpdateAngle = 1.0f;  // degrees between the sun directions of the two shadow maps
 	} settings;
 
 	bool needPrecompute = false;
 	uint shadowUpdateIdx = 0;
 
+	// Two shadow maps are swept for sun directions along its path and shading blends between them.
+	// The next map is only swept once the sun reached the newer one, at a pace set by how fast the sun moves.
+	static constexpr float BURST_ANGLE = 2.0f;    // degrees in a single frame, e.g. waiting, sleeping or sun/moon switch
+	static constexpr float SWEEP_SPEEDUP = 4.0f;  // finish a sweep in this fraction of the time the sun needs to get there
+	bool needBurst = true;
+	bool sweeping = false;
+	uint newerShadowMap = 0;
+	float3 shadowDirs[2];
+	float3 sweepDir;
+	float3 lastSunDir;
+	float sunAngularSpeed = 0.0f;  // radians per frame
+	float sweepBudget = 0.0f;
+	float shadowBlend = 1.0f;
+	uint edgePxCoord = 0;
+	int signDir = 1;
+	uint maxUpdates = 1;
+
 	struct HeightMapMetadata
 	{
 		std::wstring dir;
@@ -35,7 +54,20 @@ struct TerrainShadows : public Feature
 		float2 zRange;
 	};
 	std::unordered_map<std::string, HeightMapMetadata> heightmaps;
-	HeightMapMetadata* cachedHeightmap;
+	HeightMapMetadata* cachedHeightmap = nullptr;
+
+	// The heightmap list is cached on disk and only rebuilt when one of the directories changed
+	const std::string heightmapIndexPath = "Data\\ShaderCache\\TerrainShadows\\HeightmapIndex.json";
+	static constexpr uint HEIGHTMAP_INDEX_VERSION = 1;
+
+	// Heightmaps are read and uploaded on a worker, the render thread only swaps in the finished texture
+	struct PendingHeightmap
+	{
+		std::string worldspace;
+		std::future<std::unique_ptr<Texture2D>> texture;
+	};
+	std::optional<PendingHeightmap> pendingHeightmap;
+	std::atomic<bool> loadingScreenOpen = false;
 
 	struct ShadowUpdateCB
 	{
@@ -43,7 +75,7 @@ struct TerrainShadows : public Feature
 		float2 LightDeltaZ;  // per LightUVDir, upper penumbra and lower, should be negative
 		uint StartPxCoord;
 		float2 PxSize;
-		uint pad0[1];
+		float pad0;
 		float2 PosRange;
 		float2 ZRange;
 	} shadowUpdateCBData;
@@ -56,6 +88,8 @@ struct TerrainShadows : public Feature
 		float3 Scale;
 		float2 ZRange;
 		float2 Offset;
+		float ShadowBlend;
+		float3 pad0;
 	};
 
 	PerFrame GetCommonBufferData();
@@ -63,19 +97,30 @@ struct TerrainShadows : public Feature
 	winrt::com_ptr<ID3D11ComputeShader> shadowUpdateProgram = nullptr;
 
 	std::unique_ptr<Texture2D> texHeightMap = nullptr;
-	std::unique_ptr<Texture2D> texShadowHeight = nullptr;
+	std::unique_ptr<Texture2D> texShadowHeight[2] = { nullptr, nullptr };
 
 	bool IsHeightMapReady();
 
 	virtual void SetupResources() override;
 	void ParseHeightmapPath(std::filesystem::path p, bool xlodgen_style);
+	void ScanHeightmaps();
+	std::map<std::string, int64_t> GetHeightmapDirectories();
+	bool LoadHeightmapIndex();
+	void SaveHeightmapIndex();
 	void CompileComputeShaders();
 
 	virtual void DrawSettings() override;
 
+	virtual void DataLoaded() override;
+	virtual void Reset() override;
 	virtual void EarlyPrepass() override;
+	static std::string GetCurrentWorldspace();
+	void RequestHeightmap(const std::string& a_worldspace);
+	static std::unique_ptr<Texture2D> CreateHeightmapTexture(std::filesystem::path a_path);
 	void LoadHeightmap();
 	void Precompute();
+	void SetupSweep(float3 a_dirLightDir);
+	void DispatchSweep(Texture2D* a_target, uint a_count);
 	void UpdateShadow();
 
 	virtual void LoadSettings(json& o_json) override;
@@ -84,4 +129,35 @@ struct TerrainShadows : public Feature
 	virtual inline void RestoreDefaultSettings() override { settings = {}; }
 	virtual void ClearShaderCache() override;
 	virtual bool SupportsVR() override { return true; };
+
+	// Event handler
+	class MenuOpenCloseEventHandler : public RE::BSTEventSink<RE::MenuOpenCloseEvent>
+	{
+	public:
+		virtual RE::BSEventNotifyControl ProcessEvent(const RE::MenuOpenCloseEvent* a_event, RE::BSTEventSource<RE::MenuOpenCloseEvent>*)
+		{
+			// The destination worldspace is set while the loadscreen is up, so its heightmap can be read before gameplay resumes
+			if (a_event->menuName == RE::LoadingMenu::MENU_NAME)
+				GetSingleton()->loadingScreenOpen = a_event->opening;
+
+			return RE::BSEventNotifyControl::kContinue;
+		}
+
+		static bool Register()
+		{
+			static MenuOpenCloseEventHandler singleton;
+			auto ui = RE::UI::GetSingleton();
+
+			if (!ui) {
+				logger::error("UI event source not found");
+				return false;
+			}
+
+			ui->GetEventSource<RE::MenuOpenCloseEvent>()->AddEventSink(&singleton);
+
+			logger::info("Registered {}", typeid(singleton).name());
+
+			return true;
+		}
+	};
 };
\ No newline at end of file
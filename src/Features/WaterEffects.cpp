@@ -1,5 +1,6 @@
 #include "WaterEffects.h"
 
+#include "ExtendedRendererState.h"
 #include "State.h"
 #include "Util.h"
 
@@ -15,9 +16,7 @@ void WaterEffects::SetupResources()
 
 void WaterEffects::Prepass()
 {
-	auto& context = State::GetSingleton()->context;
-	auto srv = causticsView.get();
-	context->PSSetShaderResources(65, 1, &srv);
+	ExtendedRendererState::GetSingleton()->SetPSResource(65, causticsView.get());
 }
 
 bool WaterEffects::HasShaderDefine(RE::BSShader::Type)
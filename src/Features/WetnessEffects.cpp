@@ -1,5 +1,6 @@
 #include "WetnessEffects.h"
 
+#include "ExtendedRendererState.h"
 #include "Util.h"
 
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(
@@ -268,10 +269,7 @@ void WetnessEffects::Prepass()
 	static auto renderer = RE::BSGraphics::Renderer::GetSingleton();
 	static auto& precipOcclusionTexture = renderer->GetDepthStencilData().depthStencils[RE::RENDER_TARGETS_DEPTHSTENCIL::kPRECIPITATION_OCCLUSION_MAP];
 
-	auto state = State::GetSingleton();
-	auto& context = state->context;
-
-	context->PSSetShaderResources(70, 1, &precipOcclusionTexture.depthSRV);
+	ExtendedRendererState::GetSingleton()->SetPSResource(70, precipOcclusionTexture.depthSRV);
 }
 
 void WetnessEffects::LoadSettings(json& o_json)
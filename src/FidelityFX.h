@@ -20,5 +20,5 @@ public:
 
 	void CreateFSRResources();
 	void DestroyFSRResources();
-	void Upscale(Texture2D* a_color, Texture2D* a_alphaMask, float2 a_jitter, bool a_reset, float a_sharpness);
+	void Upscale(ID3D11Resource* a_colorIn, ID3D11Resource* a_colorOut, Texture2D* a_alphaMask, float2 a_jitter, bool a_reset, float a_sharpness);
 };
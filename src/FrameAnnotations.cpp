@@ -7,15 +7,29 @@
 
 namespace FrameAnnotations
 {
+	// Labels that change per call are formatted into a reused buffer, annotations run per draw and must not allocate
+	template <class... Args>
+	std::string_view FormatLabel(std::format_string<Args...> a_format, Args&&... a_args)
+	{
+		thread_local char buffer[512];
+		auto result = std::format_to_n(buffer, std::size(buffer), a_format, std::forward<Args>(a_args)...);
+		return { buffer, (size_t)(result.out - buffer) };
+	}
+
+	// Labels that only depend on template arguments are widened once
+	inline std::wstring WidenLabel(std::string_view a_label)
+	{
+		return std::wstring(a_label.begin(), a_label.end());
+	}
+
 	template <RE::BSShader::Type ShaderType>
 	struct BSShader_SetupGeometry
 	{
 		static void thunk(RE::BSShader* shader, RE::BSRenderPass* pass, uint32_t renderFlags)
 		{
 			if (VariableCache::GetSingleton()->state->frameAnnotations) {
-				const std::string passName = std::format("[{}:{:X}] <{}> {}", magic_enum::enum_name(ShaderType), pass->passEnum,
-					pass->accumulationHint, pass->geometry->name.c_str());
-				VariableCache::GetSingleton()->state->BeginPerfEvent(passName);
+				VariableCache::GetSingleton()->state->BeginPerfEvent(FormatLabel("[{}:{:X}] <{}> {}", magic_enum::enum_name(ShaderType), pass->passEnum,
+					pass->accumulationHint, pass->geometry->name.c_str()));
 			}
 
 			func(shader, pass, renderFlags);
@@ -44,7 +58,8 @@ namespace FrameAnnotations
 	{
 		static void thunk(void* imageSpaceShader, RE::BSTriShape* shape, RE::ImageSpaceEffectParam* param)
 		{
-			VariableCache::GetSingleton()->state->BeginPerfEvent(std::format("{} Draw", magic_enum::enum_name(EffectType)));
+			static const std::wstring label = WidenLabel(std::format("{} Draw", magic_enum::enum_name(EffectType)));
+			VariableCache::GetSingleton()->state->BeginPerfEvent(label.c_str());
 
 			func(imageSpaceShader, shape, param);
 
@@ -59,7 +74,8 @@ namespace FrameAnnotations
 	{
 		static void thunk(void* imageSpaceShader, uint32_t a1, uint32_t a2, uint32_t a3)
 		{
-			VariableCache::GetSingleton()->state->BeginPerfEvent(std::format("{} Dispatch", magic_enum::enum_name(EffectType)));
+			static const std::wstring label = WidenLabel(std::format("{} Dispatch", magic_enum::enum_name(EffectType)));
+			VariableCache::GetSingleton()->state->BeginPerfEvent(label.c_str());
 
 			func(imageSpaceShader, a1, a2, a3);
 
@@ -75,7 +91,7 @@ namespace FrameAnnotations
 		{
 			const bool frameAnnotations = VariableCache::GetSingleton()->state->frameAnnotations;
 			if (frameAnnotations) {
-				VariableCache::GetSingleton()->state->BeginPerfEvent(std::format("BSShaderAccumulator::FinishAccumulatingDispatch [{}] <{}>",
+				VariableCache::GetSingleton()->state->BeginPerfEvent(FormatLabel("BSShaderAccumulator::FinishAccumulatingDispatch [{}] <{}>",
 					static_cast<uint32_t>(shaderAccumulator->GetRuntimeData().renderMode), renderFlags));
 			}
 
@@ -93,7 +109,7 @@ namespace FrameAnnotations
 	{
 		static void thunk(RE::NiAVObject* camera, int a2, bool a3, bool a4, bool a5)
 		{
-			VariableCache::GetSingleton()->state->BeginPerfEvent(std::format("Cubemap {}", camera->name.c_str()));
+			VariableCache::GetSingleton()->state->BeginPerfEvent(FormatLabel("Cubemap {}", camera->name.c_str()));
 
 			func(camera, a2, a3, a4, a5);
 
@@ -153,7 +169,7 @@ namespace FrameAnnotations
 		{
 			const bool frameAnnotations = VariableCache::GetSingleton()->state->frameAnnotations;
 			if (frameAnnotations) {
-				VariableCache::GetSingleton()->state->BeginPerfEvent(std::format("BSBatchRenderer::RenderBatches ({:X})[{}] <{}>", *currentPass, *bucketIndex,
+				VariableCache::GetSingleton()->state->BeginPerfEvent(FormatLabel("BSBatchRenderer::RenderBatches ({:X})[{}] <{}>", *currentPass, *bucketIndex,
 					renderFlags));
 			}
 
@@ -265,7 +281,7 @@ namespace FrameAnnotations
 		{
 			const bool frameAnnotations = VariableCache::GetSingleton()->state->frameAnnotations;
 			if (frameAnnotations) {
-				VariableCache::GetSingleton()->state->BeginPerfEvent(std::format("BSShaderAccumulator::RenderBatches ({:X}:{:X})[{}] <{}>", firstPass, lastPass, groupIndex,
+				VariableCache::GetSingleton()->state->BeginPerfEvent(FormatLabel("BSShaderAccumulator::RenderBatches ({:X}:{:X})[{}] <{}>", firstPass, lastPass, groupIndex,
 					renderFlags));
 			}
 
@@ -284,7 +300,7 @@ namespace FrameAnnotations
 		{
 			const bool frameAnnotations = VariableCache::GetSingleton()->state->frameAnnotations;
 			if (frameAnnotations) {
-				VariableCache::GetSingleton()->state->BeginPerfEvent(std::format("BSShaderAccumulator::RenderPersistentPassList <{}>", renderFlags));
+				VariableCache::GetSingleton()->state->BeginPerfEvent(FormatLabel("BSShaderAccumulator::RenderPersistentPassList <{}>", renderFlags));
 			}
 
 			func(passList, renderFlags);
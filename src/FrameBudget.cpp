@@ -0,0 +1,122 @@
+#include "FrameBudget.h"
+
+#include "Feature.h"
+#include "Profiler.h"
+#include "Util.h"
+
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(
+	FrameBudget::Settings,
+	Enabled,
+	Budget,
+	Hysteresis);
+
+void FrameBudget::Update()
+{
+	if (!settings.Enabled) {
+		if (!lowered.empty())
+			ResetLevels();
+		return;
+	}
+
+	framesSinceChange++;
+
+	auto profiler = Profiler::GetSingleton();
+
+	float total = 0.0f;
+	for (auto* feature : Feature::GetFeatureList()) {
+		if (feature->loaded)
+			total += profiler->GetGPUTime(feature);
+	}
+
+	if (total > settings.Budget) {
+		if (framesSinceChange < LOWER_INTERVAL)
+			return;
+
+		// The most expensive feature that can still go lower gives the biggest saving per step
+		Feature* target = nullptr;
+		float targetTime = 0.0f;
+		for (auto* feature : Feature::GetFeatureList()) {
+			if (!feature->loaded || levels[feature] + 1 >= feature->GetQualityLevelCount())
+				continue;
+
+			float time = profiler->GetGPUTime(feature);
+			if (time > targetTime) {
+				target = feature;
+				targetTime = time;
+			}
+		}
+
+		if (target) {
+			SetLevel(target, levels[target] + 1);
+			lowered.push_back(target);
+		}
+	} else if (!lowered.empty() && total < settings.Budget * (1.0f - settings.Hysteresis)) {
+		if (framesSinceChange < RAISE_INTERVAL)
+			return;
+
+		auto* feature = lowered.back();
+		lowered.pop_back();
+		SetLevel(feature, levels[feature] - 1);
+	}
+}
+
+void FrameBudget::SetLevel(Feature* a_feature, uint a_level)
+{
+	levels[a_feature] = a_level;
+	a_feature->SetQualityLevel(a_level);
+	framesSinceChange = 0;
+}
+
+void FrameBudget::ResetLevels()
+{
+	for (auto& [feature, level] : levels) {
+		if (level)
+			feature->SetQualityLevel(0);
+		level = 0;
+	}
+	lowered.clear();
+	framesSinceChange = 0;
+}
+
+void FrameBudget::DrawSettings()
+{
+	if (ImGui::CollapsingHeader("Frame Budget", ImGuiTreeNodeFlags_DefaultOpen | ImGuiTreeNodeFlags_OpenOnArrow | ImGuiTreeNodeFlags_OpenOnDoubleClick)) {
+		ImGui::Checkbox("Enable Frame Budget", &settings.Enabled);
+		if (auto _tt = Util::HoverTooltipWrapper())
+			ImGui::Text(
+				"Lowers the quality of the most expensive features while their combined GPU time is over the budget.\n"
+				"Feature settings are the highest quality used and are not changed.");
+
+		if (settings.Enabled) {
+			ImGui::Indent();
+			ImGui::SliderFloat("GPU Budget", &settings.Budget, 0.5f, 16.0f, "%.2f ms", ImGuiSliderFlags_AlwaysClamp);
+			if (auto _tt = Util::HoverTooltipWrapper())
+				ImGui::Text("GPU time for all features, as listed under Feature Costs.");
+			ImGui::SliderFloat("Hysteresis", &settings.Hysteresis, 0.05f, 0.5f, "%.2f", ImGuiSliderFlags_AlwaysClamp);
+			if (auto _tt = Util::HoverTooltipWrapper())
+				ImGui::Text("Fraction of the budget that must be free before quality is raised again.");
+
+			for (auto* feature : Feature::GetFeatureList()) {
+				uint count = feature->GetQualityLevelCount();
+				if (feature->loaded && count > 1)
+					ImGui::BulletText("%s: level %u of %u", feature->GetName().c_str(), levels[feature], count - 1);
+			}
+			ImGui::Unindent();
+		}
+	}
+}
+
+void FrameBudget::SaveSettings(json& o_json)
+{
+	o_json = settings;
+}
+
+void FrameBudget::LoadSettings(json& o_json)
+{
+	settings = o_json;
+}
+
+void FrameBudget::RestoreDefaultSettings()
+{
+	settings = {};
+}
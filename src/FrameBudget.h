@@ -0,0 +1,50 @@
+#pragma once
+
+struct Feature;
+
+/**
+ * Frame budget governor.
+ * Steps features along their quality ladders (Feature::GetQualityLevelCount) so that the GPU time the
+ * Profiler measures for all features stays within a budget. The most expensive feature is lowered first
+ * and features are raised again in reverse order once there is enough headroom.
+ */
+class FrameBudget
+{
+public:
+	static FrameBudget* GetSingleton()
+	{
+		static FrameBudget singleton;
+		return &singleton;
+	}
+
+	inline std::string GetShortName() { return "FrameBudget"; }
+
+	struct Settings
+	{
+		bool Enabled = false;
+		float Budget = 4.0f;       // ms of GPU time for all features
+		float Hysteresis = 0.2f;  // headroom needed before quality is raised again
+	};
+
+	Settings settings;
+
+	// Profiler times are smoothed, wait for a change to show up before reacting again
+	static constexpr uint LOWER_INTERVAL = 60;
+	static constexpr uint RAISE_INTERVAL = 180;
+
+	// Called once per frame at present, after the Profiler
+	void Update();
+
+	void DrawSettings();
+	void SaveSettings(json& o_json);
+	void LoadSettings(json& o_json);
+	void RestoreDefaultSettings();
+
+private:
+	void SetLevel(Feature* a_feature, uint a_level);
+	void ResetLevels();
+
+	std::unordered_map<Feature*, uint> levels;
+	std::vector<Feature*> lowered;  // features in the order they were lowered
+	uint framesSinceChange = 0;
+};
@@ -16,9 +16,12 @@
 #include "Features/LightLimitFix/ParticleLights.h"
 
 #include "Deferred.h"
+#include "FrameBudget.h"
+#include "Profiler.h"
 #include "TruePBR.h"
 
 #include "Streamline.h"
+#include "TexturePool.h"
 #include "Upscaling.h"
 
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(
@@ -492,7 +495,8 @@ void Menu::DrawSettings()
 			auto menuList = std::vector<MenuFuncInfo>{
 				BuiltInMenu{ "General", [&]() { DrawGeneralSettings(); } },
 				BuiltInMenu{ "Advanced", [&]() { DrawAdvancedSettings(); } },
-				BuiltInMenu{ "Display", [&]() { DrawDisplaySettings(); } }
+				BuiltInMenu{ "Display", [&]() { DrawDisplaySettings(); } },
+				BuiltInMenu{ "Performance", [&]() { DrawPerformanceSettings(); } }
 			};
 
 			menuList.push_back("Core Features"s);
@@ -854,6 +858,8 @@ void Menu::DrawAdvancedSettings()
 		}
 		if (ImGui::TreeNodeEx("Statistics", ImGuiTreeNodeFlags_DefaultOpen)) {
 			ImGui::Text(std::format("Shader Compiler : {}", shaderCache.GetShaderStatsString()).c_str());
+			auto texturePool = TexturePool::GetSingleton();
+			ImGui::Text(std::format("Texture Pool : {} textures, {:.1f} MB", texturePool->entries.size(), texturePool->GetMemoryUsage() / (1024.0 * 1024.0)).c_str());
 			ImGui::TreePop();
 		}
 		ImGui::Checkbox("Frame Annotations", &State::GetSingleton()->frameAnnotations);
@@ -995,6 +1001,12 @@ void Menu::DrawDisplaySettings()
 	}
 }
 
+void Menu::DrawPerformanceSettings()
+{
+	FrameBudget::GetSingleton()->DrawSettings();
+	Profiler::GetSingleton()->DrawSettings();
+}
+
 void Menu::DrawFooter()
 {
 	ImGui::BulletText(std::format("Game Version: {} {}", magic_enum::enum_name(REL::Module::GetRuntime()), Util::GetFormattedVersion(REL::Module::get().version()).c_str()).c_str());
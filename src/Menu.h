@@ -174,6 +174,7 @@ private:
 	void DrawGeneralSettings();
 	void DrawAdvancedSettings();
 	void DrawDisplaySettings();
+	void DrawPerformanceSettings();
 	void DrawDisableAtBootSettings();
 	void DrawFooter();
 
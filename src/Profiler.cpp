@@ -0,0 +1,201 @@
+#include "Profiler.h"
+
+#include <DirectXTex.h>
+
+#include "Feature.h"
+#include "State.h"
+#include "Util.h"
+
+static thread_local Feature* currentOwner = nullptr;
+
+Profiler::Scope::Scope(Feature* a_feature) :
+	previousOwner(currentOwner)
+{
+	currentOwner = a_feature;
+	range = Profiler::GetSingleton()->BeginRange(a_feature);
+}
+
+Profiler::Scope::~Scope()
+{
+	Profiler::GetSingleton()->EndRange(range);
+	currentOwner = previousOwner;
+}
+
+Feature* Profiler::GetCurrentOwner()
+{
+	return currentOwner;
+}
+
+uint64_t Profiler::GetTextureSize(DXGI_FORMAT a_format, uint a_width, uint a_height, uint a_depth, uint a_mipLevels, uint a_arraySize)
+{
+	uint64_t bitsPerPixel = DirectX::BitsPerPixel(a_format);
+
+	uint64_t size = 0;
+	for (uint mip = 0; mip < std::max(a_mipLevels, 1u); mip++)
+		size += (uint64_t)std::max(a_width >> mip, 1u) * std::max(a_height >> mip, 1u) * std::max(a_depth >> mip, 1u) * bitsPerPixel / 8;
+	return size * std::max(a_arraySize, 1u);
+}
+
+void Profiler::TrackMemory(Feature* a_owner, int64_t a_bytes)
+{
+	if (!a_bytes)
+		return;
+
+	std::lock_guard lock(memoryMutex);
+	memory[a_owner] += a_bytes;
+}
+
+uint Profiler::BeginRange(Feature* a_feature)
+{
+	// Resources created on loader threads are still charged, only their GPU time is not
+	if (!frameActive || std::this_thread::get_id() != renderThread)
+		return UINT_MAX;
+
+	auto& frame = frames[frameIndex];
+	if (frame.used == frame.ranges.size()) {
+		auto device = State::GetSingleton()->device;
+
+		D3D11_QUERY_DESC desc{};
+		desc.Query = D3D11_QUERY_TIMESTAMP;
+
+		auto& range = frame.ranges.emplace_back();
+		DX::ThrowIfFailed(device->CreateQuery(&desc, range.begin.put()));
+		DX::ThrowIfFailed(device->CreateQuery(&desc, range.end.put()));
+	}
+
+	auto& range = frame.ranges[frame.used];
+	range.feature = a_feature;
+	State::GetSingleton()->context->End(range.begin.get());
+	return frame.used++;
+}
+
+void Profiler::EndRange(uint a_range)
+{
+	if (a_range == UINT_MAX)
+		return;
+
+	State::GetSingleton()->context->End(frames[frameIndex].ranges[a_range].end.get());
+}
+
+void Profiler::NewFrame()
+{
+	auto context = State::GetSingleton()->context;
+	renderThread = std::this_thread::get_id();
+
+	if (frameActive) {
+		auto& previous = frames[frameIndex];
+		context->End(previous.disjoint.get());
+		previous.pending = true;
+		frameIndex = (frameIndex + 1) % Latency;
+	}
+
+	auto& frame = frames[frameIndex];
+
+	// The queries in this slot were issued Latency frames ago
+	if (frame.pending)
+		Resolve(context, frame);
+
+	if (!frame.disjoint) {
+		D3D11_QUERY_DESC desc{};
+		desc.Query = D3D11_QUERY_TIMESTAMP_DISJOINT;
+		DX::ThrowIfFailed(State::GetSingleton()->device->CreateQuery(&desc, frame.disjoint.put()));
+	}
+
+	frame.used = 0;
+	context->Begin(frame.disjoint.get());
+	frameActive = true;
+}
+
+void Profiler::Resolve(ID3D11DeviceContext* a_context, Frame& a_frame)
+{
+	a_frame.pending = false;
+
+	// Never flush or spin here, a late frame is simply dropped
+	D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjointData{};
+	if (a_context->GetData(a_frame.disjoint.get(), &disjointData, sizeof(disjointData), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK || disjointData.Disjoint)
+		return;
+
+	for (auto& [feature, time] : frameTimes)
+		time = 0.0f;
+
+	for (uint i = 0; i < a_frame.used; i++) {
+		auto& range = a_frame.ranges[i];
+
+		UINT64 beginTime = 0;
+		UINT64 endTime = 0;
+		if (a_context->GetData(range.begin.get(), &beginTime, sizeof(beginTime), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK ||
+			a_context->GetData(range.end.get(), &endTime, sizeof(endTime), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+			return;
+
+		frameTimes[range.feature] += (float)((double)(endTime - beginTime) / (double)disjointData.Frequency * 1000.0);
+	}
+
+	// Features that did no work this frame decay towards zero
+	for (auto& [feature, time] : frameTimes) {
+		auto [it, inserted] = gpuTimes.try_emplace(feature, time);
+		if (!inserted)
+			it->second = std::lerp(it->second, time, 0.05f);
+	}
+}
+
+float Profiler::GetGPUTime(Feature* a_feature)
+{
+	auto it = gpuTimes.find(a_feature);
+	return it != gpuTimes.end() ? it->second : 0.0f;
+}
+
+void Profiler::DrawSettings()
+{
+	if (ImGui::CollapsingHeader("Feature Costs", ImGuiTreeNodeFlags_DefaultOpen | ImGuiTreeNodeFlags_OpenOnArrow | ImGuiTreeNodeFlags_OpenOnDoubleClick)) {
+		ImGui::TextWrapped(
+			"Video memory of resources each feature created and GPU time of its passes, averaged over recent frames. "
+			"Work done by the game itself for a feature, such as extra draws, is not included.");
+
+		std::unordered_map<Feature*, int64_t> memorySnapshot;
+		{
+			std::lock_guard lock(memoryMutex);
+			memorySnapshot = memory;
+		}
+
+		if (ImGui::BeginTable("##FeatureCosts", 3, ImGuiTableFlags_SizingStretchProp | ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders)) {
+			ImGui::TableSetupColumn("Feature");
+			ImGui::TableSetupColumn("VRAM (MB)");
+			ImGui::TableSetupColumn("GPU (ms)");
+			ImGui::TableHeadersRow();
+
+			int64_t totalMemory = 0;
+			float totalTime = 0.0f;
+
+			auto drawRow = [&](const char* a_name, Feature* a_feature) {
+				auto memoryIt = memorySnapshot.find(a_feature);
+				int64_t bytes = memoryIt != memorySnapshot.end() ? memoryIt->second : 0;
+				float time = GetGPUTime(a_feature);
+
+				totalMemory += bytes;
+				totalTime += time;
+
+				ImGui::TableNextColumn();
+				ImGui::Text("%s", a_name);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.1f", (double)bytes / (1024.0 * 1024.0));
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", time);
+			};
+
+			for (auto* feature : Feature::GetFeatureList()) {
+				if (feature->loaded)
+					drawRow(feature->GetName().c_str(), feature);
+			}
+			drawRow("Other", nullptr);
+
+			ImGui::TableNextColumn();
+			ImGui::TextDisabled("Total");
+			ImGui::TableNextColumn();
+			ImGui::TextDisabled("%.1f", (double)totalMemory / (1024.0 * 1024.0));
+			ImGui::TableNextColumn();
+			ImGui::TextDisabled("%.3f", totalTime);
+
+			ImGui::EndTable();
+		}
+	}
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <d3d11.h>
+#include <winrt/base.h>
+
+struct Feature;
+
+/**
+ * Per-feature VRAM and GPU time accounting.
+ * Resources created through the Buffer.h wrappers are charged to the feature of the innermost Scope on that thread.
+ * GPU time of each Scope on the render thread is measured with pooled timestamp queries inside one disjoint
+ * query per frame, read back Latency frames later so the CPU never waits on the GPU.
+ */
+class Profiler
+{
+public:
+	static Profiler* GetSingleton()
+	{
+		static Profiler singleton;
+		return &singleton;
+	}
+
+	static constexpr uint Latency = 4;
+
+	// Charges resources created and GPU work issued during its lifetime to a feature, should not be nested for the same feature
+	class Scope
+	{
+	public:
+		explicit Scope(Feature* a_feature);
+		~Scope();
+
+	private:
+		Feature* previousOwner;
+		uint range = UINT_MAX;
+	};
+
+	static Feature* GetCurrentOwner();
+	static uint64_t GetTextureSize(DXGI_FORMAT a_format, uint a_width, uint a_height, uint a_depth, uint a_mipLevels, uint a_arraySize);
+
+	void TrackMemory(Feature* a_owner, int64_t a_bytes);
+
+	// Called once per frame at present
+	void NewFrame();
+
+	// Smoothed GPU time in milliseconds
+	float GetGPUTime(Feature* a_feature);
+
+	void DrawSettings();
+
+private:
+	struct Range
+	{
+		Feature* feature = nullptr;
+		winrt::com_ptr<ID3D11Query> begin;
+		winrt::com_ptr<ID3D11Query> end;
+	};
+
+	struct Frame
+	{
+		winrt::com_ptr<ID3D11Query> disjoint;
+		std::vector<Range> ranges;  // grows to the most scopes seen in a frame, then reused
+		uint used = 0;
+		bool pending = false;
+	};
+
+	uint BeginRange(Feature* a_feature);
+	void EndRange(uint a_range);
+	void Resolve(ID3D11DeviceContext* a_context, Frame& a_frame);
+
+	Frame frames[Latency];
+	uint frameIndex = 0;
+	bool frameActive = false;
+	std::thread::id renderThread;
+
+	std::unordered_map<Feature*, float> gpuTimes;
+	std::unordered_map<Feature*, float> frameTimes;
+
+	std::mutex memoryMutex;
+	std::unordered_map<Feature*, int64_t> memory;
+};
+
+/**
+ * Charges the memory of a Buffer.h wrapper to the feature in the current Profiler::Scope for its lifetime.
+ */
+class TrackedMemory
+{
+public:
+	TrackedMemory() = default;
+
+	explicit TrackedMemory(uint64_t a_bytes) :
+		owner(Profiler::GetCurrentOwner()), bytes(a_bytes)
+	{
+		Profiler::GetSingleton()->TrackMemory(owner, (int64_t)bytes);
+	}
+
+	TrackedMemory(const TrackedMemory& a_other) :
+		owner(a_other.owner), bytes(a_other.bytes)
+	{
+		Profiler::GetSingleton()->TrackMemory(owner, (int64_t)bytes);
+	}
+
+	TrackedMemory& operator=(const TrackedMemory& a_other)
+	{
+		if (this != &a_other) {
+			Profiler::GetSingleton()->TrackMemory(owner, -(int64_t)bytes);
+			owner = a_other.owner;
+			bytes = a_other.bytes;
+			Profiler::GetSingleton()->TrackMemory(owner, (int64_t)bytes);
+		}
+		return *this;
+	}
+
+	~TrackedMemory()
+	{
+		Profiler::GetSingleton()->TrackMemory(owner, -(int64_t)bytes);
+	}
+
+private:
+	Feature* owner = nullptr;
+	uint64_t bytes = 0;
+};
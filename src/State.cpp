@@ -5,10 +5,13 @@
 #include <magic_enum.hpp>
 #include <pystring/pystring.h>
 
+#include "ExtendedRendererState.h"
 #include "Menu.h"
+#include "Profiler.h"
 #include "ShaderCache.h"
 
 #include "Feature.h"
+#include "FrameBudget.h"
 
 #include "Deferred.h"
 #include "Features/CloudShadows.h"
@@ -16,9 +19,11 @@
 #include "TruePBR.h"
 
 #include "Streamline.h"
+#include "TexturePool.h"
 #include "Upscaling.h"
 
 #include "VariableCache.h"
+#include "WaterCache.h"
 
 void State::Draw()
 {
@@ -27,7 +32,6 @@ void State::Draw()
 	auto deferred = variableCache->deferred;
 	auto terrainBlending = variableCache->terrainBlending;
 	auto cloudShadows = variableCache->cloudShadows;
-	auto truePBR = variableCache->truePBR;
 	auto smState = variableCache->smState;
 
 	if (shaderCache->IsEnabled()) {
@@ -37,7 +41,7 @@ void State::Draw()
 		if (cloudShadows->loaded)
 			cloudShadows->SkyShaderHacks();
 
-		truePBR->SetShaderResouces(context);
+		ExtendedRendererState::GetSingleton()->Flush(context);
 
 		if (auto accumulator = RE::BSGraphics::BSShaderAccumulator::GetCurrentAccumulator()) {
 			// Set an unused bit to indicate if we are rendering an object in the main rendering passes
@@ -49,6 +53,7 @@ void State::Draw()
 		if (deferred->inDecals)
 			currentExtraDescriptor |= (uint32_t)ExtraShaderDescriptors::IsDecal;
 
+		bool bindPermutationBuffer = false;
 		if (forceUpdatePermutationBuffer || currentPixelDescriptor != lastPixelDescriptor || currentExtraDescriptor != lastExtraDescriptor) {
 			PermutationCB data{};
 			data.VertexShaderDescriptor = currentVertexDescriptor;
@@ -62,16 +67,22 @@ void State::Draw()
 			lastExtraDescriptor = currentExtraDescriptor;
 
 			forceUpdatePermutationBuffer = false;
+			bindPermutationBuffer = true;
 		}
 
 		currentExtraDescriptor = 0;
 
 		if (frameChecker.IsNewFrame()) {
-			ID3D11Buffer* buffers[3] = { permutationCB->CB(), sharedDataCB->CB(), featureDataCB->CB() };
-			context->PSSetConstantBuffers(4, 3, buffers);
-			context->CSSetConstantBuffers(5, 2, buffers + 1);
+			ID3D11Buffer* buffers[2] = { sharedDataCB->CB(), featureDataCB->CB() };
+			context->PSSetConstantBuffers(5, 2, buffers);
+			context->CSSetConstantBuffers(5, 2, buffers);
+			bindPermutationBuffer = true;
 		}
 
+		// Every update is a new sub-allocation of the upload ring
+		if (bindPermutationBuffer)
+			permutationCB->PSSet(context, 4);
+
 		if (currentShader && updateShader) {
 			auto type = currentShader->shaderType.get();
 			if (type == RE::BSShader::Type::Utility) {
@@ -86,8 +97,9 @@ void State::Draw()
 					currentPixelDescriptor &= ~modifiedPixelDescriptor;
 
 					if (frameAnnotations) {
-						BeginPerfEvent(std::format("Draw: CS {}::{:x}::{}", magic_enum::enum_name(currentShader->shaderType.get()), currentPixelDescriptor, currentShader->fxpFilename));
-						SetPerfMarker(std::format("Defines: {}", SIE::ShaderCache::GetDefinesString(*currentShader, currentPixelDescriptor)));
+						const auto& annotation = GetDrawAnnotation(*currentShader, currentPixelDescriptor);
+						BeginPerfEvent(annotation.event.c_str());
+						SetPerfMarker(annotation.defines.c_str());
 						EndPerfEvent();
 					}
 				}
@@ -102,6 +114,10 @@ void State::Reset()
 	for (auto* feature : Feature::GetFeatureList())
 		if (feature->loaded)
 			feature->Reset();
+	Profiler::GetSingleton()->NewFrame();
+	TexturePool::GetSingleton()->EndFrame();
+	ExtendedRendererState::GetSingleton()->Invalidate();
+	FrameBudget::GetSingleton()->Update();
 	if (!RE::UI::GetSingleton()->GameIsPaused())
 		timer += RE::GetSecondsSinceLastFrame();
 	lastModifiedPixelDescriptor = 0;
@@ -116,9 +132,12 @@ void State::Setup()
 {
 	TruePBR::GetSingleton()->SetupResources();
 	SetupResources();
-	for (auto* feature : Feature::GetFeatureList())
-		if (feature->loaded)
+	for (auto* feature : Feature::GetFeatureList()) {
+		if (feature->loaded) {
+			Profiler::Scope scope(feature);
 			feature->SetupResources();
+		}
+	}
 	Deferred::GetSingleton()->SetupResources();
 	Streamline::GetSingleton()->SetupResources();
 	if (!upscalerLoaded)
@@ -298,6 +317,20 @@ void State::Load(ConfigMode a_configMode, bool a_allowReload)
 			logger::warn("Missing settings for Streamline, using default.");
 		}
 
+		auto frameBudget = FrameBudget::GetSingleton();
+		auto& frameBudgetJson = settings[frameBudget->GetShortName()];
+		if (frameBudgetJson.is_object()) {
+			logger::info("Loading Frame Budget settings");
+			try {
+				frameBudget->LoadSettings(frameBudgetJson);
+			} catch (...) {
+				logger::warn("Invalid settings for Frame Budget, using default.");
+				frameBudget->RestoreDefaultSettings();
+			}
+		} else {
+			logger::warn("Missing settings for Frame Budget, using default.");
+		}
+
 		for (auto* feature : Feature::GetFeatureList()) {
 			try {
 				const std::string featureName = feature->GetShortName();
@@ -382,6 +415,10 @@ void State::Save(ConfigMode a_configMode)
 	auto& streamlineJson = settings[streamline->GetShortName()];
 	streamline->SaveSettings(streamlineJson);
 
+	auto frameBudget = FrameBudget::GetSingleton();
+	auto& frameBudgetJson = settings[frameBudget->GetShortName()];
+	frameBudget->SaveSettings(frameBudgetJson);
+
 	json originalShaders;
 	for (int classIndex = 0; classIndex < RE::BSShader::Type::Total - 1; ++classIndex) {
 		originalShaders[magic_enum::enum_name((RE::BSShader::Type)(classIndex + 1))] = enabledClasses[classIndex];
@@ -505,12 +542,10 @@ void State::SetupResources()
 {
 	auto renderer = RE::BSGraphics::Renderer::GetSingleton();
 
-	permutationCB = new ConstantBuffer(ConstantBufferDesc<PermutationCB>());
+	permutationCB = new ConstantBuffer(ConstantBufferDesc<PermutationCB>(), true);
 	sharedDataCB = new ConstantBuffer(ConstantBufferDesc<SharedDataCB>());
 
-	auto [data, size] = GetFeatureBufferData();
-	featureDataCB = new ConstantBuffer(ConstantBufferDesc((uint32_t)size));
-	delete[] data;
+	featureDataCB = new ConstantBuffer(ConstantBufferDesc((uint32_t)GetFeatureBufferSize()));
 
 	// Grab main texture to get resolution
 	// VR cannot use viewport->screenWidth/Height as it's the desktop preview window's resolution and not HMD
@@ -637,9 +672,24 @@ void State::ModifyShaderLookup(const RE::BSShader& a_shader, uint& a_vertexDescr
 	}
 }
 
+// Annotations are issued per draw, so titles are widened into a reused buffer instead of a new std::wstring
+static const wchar_t* WidenPerfTitle(std::string_view a_title)
+{
+	thread_local wchar_t buffer[512];
+	size_t length = std::min(a_title.size(), std::size(buffer) - 1);
+	std::copy_n(a_title.begin(), length, buffer);
+	buffer[length] = L'\0';
+	return buffer;
+}
+
 void State::BeginPerfEvent(std::string_view title)
 {
-	pPerf->BeginEvent(std::wstring(title.begin(), title.end()).c_str());
+	pPerf->BeginEvent(WidenPerfTitle(title));
+}
+
+void State::BeginPerfEvent(const wchar_t* title)
+{
+	pPerf->BeginEvent(title);
 }
 
 void State::EndPerfEvent()
@@ -649,7 +699,24 @@ void State::EndPerfEvent()
 
 void State::SetPerfMarker(std::string_view title)
 {
-	pPerf->SetMarker(std::wstring(title.begin(), title.end()).c_str());
+	pPerf->SetMarker(WidenPerfTitle(title));
+}
+
+void State::SetPerfMarker(const wchar_t* title)
+{
+	pPerf->SetMarker(title);
+}
+
+const State::DrawAnnotation& State::GetDrawAnnotation(const RE::BSShader& a_shader, uint32_t a_pixelDescriptor)
+{
+	uint64_t key = ((uint64_t)a_shader.shaderType.get() << 32) | a_pixelDescriptor;
+	auto [it, inserted] = drawAnnotations.try_emplace(key);
+	if (inserted) {
+		auto event = std::format("Draw: CS {}::{:x}::{}", magic_enum::enum_name(a_shader.shaderType.get()), a_pixelDescriptor, a_shader.fxpFilename);
+		auto defines = std::format("Defines: {}", SIE::ShaderCache::GetDefinesString(a_shader, a_pixelDescriptor));
+		it->second = { std::wstring(event.begin(), event.end()), std::wstring(defines.begin(), defines.end()) };
+	}
+	return it->second;
 }
 
 void State::SetAdapterDescription(const std::wstring& description)
@@ -691,12 +758,7 @@ void State::UpdateSharedData()
 		data.FrameCount = viewport->frameCount * (bTAA || State::GetSingleton()->upscalerLoaded);
 		data.FrameCountAlwaysActive = viewport->frameCount;
 
-		for (int i = -2; i <= 2; i++) {
-			for (int k = -2; k <= 2; k++) {
-				int waterTile = (i + 2) + ((k + 2) * 5);
-				data.WaterData[waterTile] = Util::TryGetWaterData((float)i * 4096.0f, (float)k * 4096.0f);
-			}
-		}
+		WaterCache::GetSingleton()->GetWaterData(data.WaterData);
 
 		if (auto sky = RE::Sky::GetSingleton())
 			data.InInterior = sky->mode.get() != RE::Sky::Mode::kFull;
@@ -711,19 +773,14 @@ void State::UpdateSharedData()
 		sharedDataCB->Update(data);
 	}
 
-	{
-		auto [data, size] = GetFeatureBufferData();
-
-		featureDataCB->Update(data, size);
-
-		delete[] data;
-	}
+	if (UpdateFeatureBufferData())
+		featureDataCB->Update(GetFeatureBufferData(), GetFeatureBufferSize());
 
 	const auto& depth = RE::BSGraphics::Renderer::GetSingleton()->GetDepthStencilData().depthStencils[RE::RENDER_TARGETS_DEPTHSTENCIL::kPOST_ZPREPASS_COPY];
 	auto terrainBlending = TerrainBlending::GetSingleton();
 	auto srv = (terrainBlending->loaded ? terrainBlending->blendedDepthTexture16->srv.get() : depth.depthSRV);
 
-	context->PSSetShaderResources(17, 1, &srv);
+	ExtendedRendererState::GetSingleton()->SetPSResource(17, srv);
 }
 
 void State::ClearDisabledFeatures()
@@ -100,9 +100,12 @@ public:
 	void SetupResources();
 	void ModifyShaderLookup(const RE::BSShader& a_shader, uint& a_vertexDescriptor, uint& a_pixelDescriptor, bool a_forceDeferred = false);
 
+	// Narrow titles are widened into a thread local buffer, wide titles are passed through
 	void BeginPerfEvent(std::string_view title);
+	void BeginPerfEvent(const wchar_t* title);
 	void EndPerfEvent();
 	void SetPerfMarker(std::string_view title);
+	void SetPerfMarker(const wchar_t* title);
 
 	void SetAdapterDescription(const std::wstring& description);
 
@@ -194,4 +197,14 @@ public:
 private:
 	std::shared_ptr<REX::W32::ID3DUserDefinedAnnotation> pPerf;
 	bool initialized = false;
+
+	// Draw annotation labels, built once for each shader type and pixel descriptor
+	struct DrawAnnotation
+	{
+		std::wstring event;
+		std::wstring defines;
+	};
+	std::unordered_map<uint64_t, DrawAnnotation> drawAnnotations;
+
+	const DrawAnnotation& GetDrawAnnotation(const RE::BSShader& a_shader, uint32_t a_pixelDescriptor);
 };
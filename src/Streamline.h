@@ -109,7 +109,7 @@ public:
 	void CopyResourcesToSharedBuffers();
 	void Present();
 
-	void Upscale(Texture2D* a_color, Texture2D* a_alphaMask, sl::DLSSPreset a_preset);
+	void Upscale(ID3D11Resource* a_colorIn, ID3D11Resource* a_colorOut, Texture2D* a_alphaMask, sl::DLSSPreset a_preset);
 	void UpdateConstants();
 
 	void SaveSettings(json& o_json);
@@ -0,0 +1,124 @@
+#include "TexturePool.h"
+
+#include <DirectXTex.h>
+
+#include "Util.h"
+
+static bool MatchesDesc(const D3D11_TEXTURE2D_DESC& a_lhs, const D3D11_TEXTURE2D_DESC& a_rhs)
+{
+	return a_lhs.Width == a_rhs.Width &&
+	       a_lhs.Height == a_rhs.Height &&
+	       a_lhs.MipLevels == a_rhs.MipLevels &&
+	       a_lhs.ArraySize == a_rhs.ArraySize &&
+	       a_lhs.Format == a_rhs.Format &&
+	       a_lhs.SampleDesc.Count == a_rhs.SampleDesc.Count &&
+	       a_lhs.SampleDesc.Quality == a_rhs.SampleDesc.Quality &&
+	       a_lhs.Usage == a_rhs.Usage &&
+	       a_lhs.BindFlags == a_rhs.BindFlags &&
+	       a_lhs.CPUAccessFlags == a_rhs.CPUAccessFlags &&
+	       a_lhs.MiscFlags == a_rhs.MiscFlags;
+}
+
+Texture2D* TexturePool::Acquire(const D3D11_TEXTURE2D_DESC& a_desc)
+{
+	for (auto& entry : entries) {
+		if (!entry.inUse && MatchesDesc(entry.texture->desc, a_desc)) {
+			entry.inUse = true;
+			entry.lastUsedFrame = frameCount;
+			return entry.texture.get();
+		}
+	}
+
+	auto texture = std::make_unique<Texture2D>(a_desc);
+
+	if (a_desc.BindFlags & D3D11_BIND_SHADER_RESOURCE) {
+		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {
+			.Format = a_desc.Format,
+			.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D,
+			.Texture2D = {
+				.MostDetailedMip = 0,
+				.MipLevels = a_desc.MipLevels ? a_desc.MipLevels : (UINT)-1 }
+		};
+		texture->CreateSRV(srvDesc);
+	}
+
+	if (a_desc.BindFlags & D3D11_BIND_UNORDERED_ACCESS) {
+		D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {
+			.Format = a_desc.Format,
+			.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2D,
+			.Texture2D = { .MipSlice = 0 }
+		};
+		texture->CreateUAV(uavDesc);
+	}
+
+	if (a_desc.BindFlags & D3D11_BIND_RENDER_TARGET) {
+		D3D11_RENDER_TARGET_VIEW_DESC rtvDesc = {
+			.Format = a_desc.Format,
+			.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D,
+			.Texture2D = { .MipSlice = 0 }
+		};
+		texture->CreateRTV(rtvDesc);
+	}
+
+	logger::debug("[TexturePool] Created {}x{} texture, format {}", a_desc.Width, a_desc.Height, magic_enum::enum_name(a_desc.Format));
+
+	auto& entry = entries.emplace_back();
+	entry.texture = std::move(texture);
+	entry.inUse = true;
+	entry.lastUsedFrame = frameCount;
+	return entry.texture.get();
+}
+
+void TexturePool::Release(Texture2D* a_texture)
+{
+	if (!a_texture)
+		return;
+
+	for (auto& entry : entries) {
+		if (entry.texture.get() == a_texture) {
+			entry.inUse = false;
+			return;
+		}
+	}
+}
+
+void TexturePool::EndFrame()
+{
+	frameCount++;
+
+	std::erase_if(entries, [&](const Entry& a_entry) {
+		return !a_entry.inUse && frameCount - a_entry.lastUsedFrame > EVICT_FRAMES;
+	});
+}
+
+uint64_t TexturePool::GetMemoryUsage()
+{
+	uint64_t total = 0;
+	for (auto& entry : entries) {
+		auto& desc = entry.texture->desc;
+		for (uint mip = 0; mip < std::max(desc.MipLevels, 1u); mip++)
+			total += (uint64_t)std::max(desc.Width >> mip, 1u) * std::max(desc.Height >> mip, 1u) * desc.ArraySize * DirectX::BitsPerPixel(desc.Format) / 8;
+	}
+	return total;
+}
+
+TexturePool::Pass::~Pass()
+{
+	auto pool = TexturePool::GetSingleton();
+	for (uint i = 0; i < lastReadCount; i++)
+		pool->Release(lastReads[i]);
+}
+
+Texture2D* TexturePool::Pass::Write(const D3D11_TEXTURE2D_DESC& a_desc)
+{
+	return TexturePool::GetSingleton()->Acquire(a_desc);
+}
+
+Texture2D* TexturePool::Pass::ReadLast(Texture2D* a_texture)
+{
+	if (a_texture) {
+		assert(lastReadCount < lastReads.size());
+		lastReads[lastReadCount++] = a_texture;
+	}
+	return a_texture;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Buffer.h"
+
+// Textures that only live for part of a frame, shared between passes by descriptor.
+// D3D11 cannot place resources in shared memory, so a texture released by one pass backs the next pass
+// that acquires a matching descriptor instead. Textures nobody acquired for a while are freed.
+class TexturePool
+{
+public:
+	static TexturePool* GetSingleton()
+	{
+		static TexturePool singleton;
+		return &singleton;
+	}
+
+	static constexpr uint EVICT_FRAMES = 300;
+
+	struct Entry
+	{
+		std::unique_ptr<Texture2D> texture;
+		bool inUse = false;
+		uint lastUsedFrame = 0;
+	};
+
+	std::vector<Entry> entries;
+	uint frameCount = 0;
+
+	// Returns a texture matching the descriptor with a full SRV and a mip 0 UAV/RTV for its bind flags, its contents are undefined
+	Texture2D* Acquire(const D3D11_TEXTURE2D_DESC& a_desc);
+	// The contents are undefined once released, null is ignored
+	void Release(Texture2D* a_texture);
+
+	void EndFrame();
+
+	uint64_t GetMemoryUsage();
+
+	// Lifetimes of the pooled textures one pass touches.
+	// Textures it writes are acquired when declared, textures it reads for the last time go back to the pool when it ends.
+	class Pass
+	{
+	public:
+		Pass() = default;
+		Pass(const Pass&) = delete;
+		Pass& operator=(const Pass&) = delete;
+		~Pass();
+
+		Texture2D* Write(const D3D11_TEXTURE2D_DESC& a_desc);
+		Texture2D* ReadLast(Texture2D* a_texture);
+
+	private:
+		std::array<Texture2D*, 8> lastReads{};
+		uint lastReadCount = 0;
+	};
+};
@@ -3,6 +3,7 @@
 #include "TruePBR/BSLightingShaderMaterialPBR.h"
 #include "TruePBR/BSLightingShaderMaterialPBRLandscape.h"
 
+#include "ExtendedRendererState.h"
 #include "Hooks.h"
 #include "ShaderCache.h"
 #include "State.h"
@@ -262,11 +263,9 @@ void TruePBR::SetupResources()
 
 void TruePBR::PrePass()
 {
-	auto context = VariableCache::GetSingleton()->context;
 	if (!glintsNoiseTexture)
 		SetupGlintsTexture();
-	ID3D11ShaderResourceView* srv = glintsNoiseTexture->srv.get();
-	context->PSSetShaderResources(20, 1, &srv);
+	ExtendedRendererState::GetSingleton()->SetPSResource(20, glintsNoiseTexture->srv.get());
 }
 
 void TruePBR::SetupGlintsTexture()
@@ -529,29 +528,13 @@ void TruePBR::GenerateShaderPermutations(RE::BSShader* shader)
 	}
 }
 
-struct ExtendedRendererState
-{
-	static constexpr uint32_t NumPSTextures = 12;
-	static constexpr uint32_t FirstPSTexture = 80;
-
-	uint32_t PSResourceModifiedBits = 0;
-	std::array<ID3D11ShaderResourceView*, NumPSTextures> PSTexture;
-
-	void SetPSTexture(size_t textureIndex, RE::BSGraphics::Texture* newTexture)
-	{
-		ID3D11ShaderResourceView* resourceView = newTexture ? newTexture->resourceView : nullptr;
-		//if (PSTexture[textureIndex] != resourceView)
-		{
-			PSTexture[textureIndex] = resourceView;
-			PSResourceModifiedBits |= (1 << textureIndex);
-		}
-	}
+// Landscape displacement and RMAOS textures go past the slots of the game's shadow state
+static constexpr uint LandscapeFirstPSSlot = 80;
 
-	ExtendedRendererState()
-	{
-		std::fill(PSTexture.begin(), PSTexture.end(), nullptr);
-	}
-} extendedRendererState;
+static void SetLandscapePSTexture(uint a_index, RE::BSGraphics::Texture* a_texture)
+{
+	ExtendedRendererState::GetSingleton()->SetPSResourceIfChanged(LandscapeFirstPSSlot + a_index, a_texture ? a_texture->resourceView : nullptr);
+}
 
 struct BSLightingShaderProperty_LoadBinary
 {
@@ -743,10 +726,10 @@ struct BSLightingShader_SetupMaterial
 						shadowState->SetPSTextureFilterMode(normalTextureIndex, RE::BSGraphics::TextureFilterMode::kAnisotropic);
 					}
 					if (pbrMaterial->landscapeDisplacementTextures[textureIndex] != nullptr) {
-						extendedRendererState.SetPSTexture(textureIndex, pbrMaterial->landscapeDisplacementTextures[textureIndex]->rendererTexture);
+						SetLandscapePSTexture(textureIndex, pbrMaterial->landscapeDisplacementTextures[textureIndex]->rendererTexture);
 					}
 					if (pbrMaterial->landscapeRMAOSTextures[textureIndex] != nullptr) {
-						extendedRendererState.SetPSTexture(BSLightingShaderMaterialPBRLandscape::NumTiles + textureIndex, pbrMaterial->landscapeRMAOSTextures[textureIndex]->rendererTexture);
+						SetLandscapePSTexture(BSLightingShaderMaterialPBRLandscape::NumTiles + textureIndex, pbrMaterial->landscapeRMAOSTextures[textureIndex]->rendererTexture);
 					}
 				}
 
@@ -1604,13 +1587,3 @@ void TruePBR::SetupDefaultPBRLandTextureSet()
 		}
 	}
 }
-
-void TruePBR::SetShaderResouces(ID3D11DeviceContext* a_context)
-{
-	for (uint32_t textureIndex = 0; textureIndex < ExtendedRendererState::NumPSTextures; ++textureIndex) {
-		if (extendedRendererState.PSResourceModifiedBits & (1 << textureIndex)) {
-			a_context->PSSetShaderResources(ExtendedRendererState::FirstPSTexture + textureIndex, 1, &extendedRendererState.PSTexture[textureIndex]);
-		}
-	}
-	extendedRendererState.PSResourceModifiedBits = 0;
-}
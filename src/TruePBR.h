@@ -28,7 +28,6 @@ public:
 	void PostPostLoad();
 	void DataLoaded();
 
-	void SetShaderResouces(ID3D11DeviceContext* a_context);
 	void GenerateShaderPermutations(RE::BSShader* shader);
 
 	void SetupGlintsTexture();
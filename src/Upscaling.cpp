@@ -1,6 +1,7 @@
 #include "Upscaling.h"
 
 #include "Hooks.h"
+#include "TexturePool.h"
 #include "Util.h"
 
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(
@@ -287,32 +288,50 @@ void Upscaling::Upscale()
 		state->EndPerfEvent();
 	}
 
+	bool sharpen = upscaleMethod != UpscaleMethod::kFSR && settings.sharpness > 0.0f;
+
+	// Read the game's input and write its output in place where possible, copies are only a fallback
+	bool directInput = CanReadDirectly(inputTextureResource);
+	auto directOutputUAV = GetOutputUAV(outputTextureResource);
+
+	auto texturePool = TexturePool::GetSingleton();
+
+	Texture2D* copyTexture = nullptr;
+	if (!directInput || !directOutputUAV || sharpen)
+		copyTexture = texturePool->Acquire(upscalingTextureDesc);
+
+	ID3D11Resource* upscaleInput = directInput ? inputTextureResource : copyTexture->resource.get();
+	ID3D11Resource* upscaleOutput = directOutputUAV && !sharpen ? outputTextureResource : copyTexture->resource.get();
+
 	{
 		state->BeginPerfEvent("Upscaling");
 
-		context->CopyResource(upscalingTexture->resource.get(), inputTextureResource);
+		if (!directInput)
+			context->CopyResource(copyTexture->resource.get(), inputTextureResource);
 
 		if (upscaleMethod == UpscaleMethod::kDLSS)
-			Streamline::GetSingleton()->Upscale(upscalingTexture, alphaMaskTexture, (sl::DLSSPreset)settings.dlssPreset);
+			Streamline::GetSingleton()->Upscale(upscaleInput, upscaleOutput, alphaMaskTexture, (sl::DLSSPreset)settings.dlssPreset);
 		else if (upscaleMethod == UpscaleMethod::kFSR)
-			FidelityFX::GetSingleton()->Upscale(upscalingTexture, alphaMaskTexture, jitter, reset, settings.sharpness);
+			FidelityFX::GetSingleton()->Upscale(upscaleInput, upscaleOutput, alphaMaskTexture, jitter, reset, settings.sharpness);
 
 		reset = false;
 
 		state->EndPerfEvent();
 	}
 
-	if (upscaleMethod != UpscaleMethod::kFSR && settings.sharpness > 0.0f) {
+	if (sharpen) {
 		state->BeginPerfEvent("Sharpening");
 
-		context->CopyResource(inputTextureResource, upscalingTexture->resource.get());
+		// Sharpen straight into the output, otherwise bounce through the input
+		if (!directOutputUAV)
+			context->CopyResource(inputTextureResource, copyTexture->resource.get());
 
 		{
 			{
-				ID3D11ShaderResourceView* views[1] = { inputTextureSRV };
+				ID3D11ShaderResourceView* views[1] = { directOutputUAV ? copyTexture->srv.get() : inputTextureSRV };
 				context->CSSetShaderResources(0, ARRAYSIZE(views), views);
 
-				ID3D11UnorderedAccessView* uavs[1] = { upscalingTexture->uav.get() };
+				ID3D11UnorderedAccessView* uavs[1] = { directOutputUAV ? directOutputUAV : copyTexture->uav.get() };
 				context->CSSetUnorderedAccessViews(0, ARRAYSIZE(uavs), uavs, nullptr);
 
 				context->CSSetShader(GetRCASCS(), nullptr, 0);
@@ -333,7 +352,58 @@ void Upscaling::Upscale()
 		state->EndPerfEvent();
 	}
 
-	context->CopyResource(outputTextureResource, upscalingTexture->resource.get());
+	if (!directOutputUAV)
+		context->CopyResource(outputTextureResource, copyTexture->resource.get());
+
+	texturePool->Release(copyTexture);
+}
+
+bool Upscaling::CanReadDirectly(ID3D11Resource* a_input)
+{
+	winrt::com_ptr<ID3D11Texture2D> texture;
+	if (FAILED(a_input->QueryInterface(IID_PPV_ARGS(texture.put()))))
+		return false;
+
+	D3D11_TEXTURE2D_DESC desc;
+	texture->GetDesc(&desc);
+
+	// Upscalers create their own views from the resource description, so typeless formats need the copy
+	return desc.Format == upscalingTextureDesc.Format && desc.Width == upscalingTextureDesc.Width && desc.Height == upscalingTextureDesc.Height;
+}
+
+ID3D11UnorderedAccessView* Upscaling::GetOutputUAV(ID3D11Resource* a_output)
+{
+	if (outputUAV) {
+		winrt::com_ptr<ID3D11Resource> resource;
+		outputUAV->GetResource(resource.put());
+		if (resource.get() == a_output)
+			return outputUAV.get();
+		outputUAV = nullptr;
+	}
+
+	winrt::com_ptr<ID3D11Texture2D> texture;
+	if (FAILED(a_output->QueryInterface(IID_PPV_ARGS(texture.put()))))
+		return nullptr;
+
+	D3D11_TEXTURE2D_DESC desc;
+	texture->GetDesc(&desc);
+
+	if (!(desc.BindFlags & D3D11_BIND_UNORDERED_ACCESS) || !CanReadDirectly(a_output))
+		return nullptr;
+
+	D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc{};
+	uavDesc.Format = desc.Format;
+	uavDesc.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2D;
+	uavDesc.Texture2D.MipSlice = 0;
+
+	auto device = State::GetSingleton()->device;
+	if (FAILED(device->CreateUnorderedAccessView(a_output, &uavDesc, outputUAV.put()))) {
+		outputUAV = nullptr;
+		return nullptr;
+	}
+
+	logger::info("[Upscaling] Writing upscaled output directly to the game's render target");
+	return outputUAV.get();
 }
 
 void Upscaling::SharpenTAA()
@@ -371,6 +441,9 @@ void Upscaling::SharpenTAA()
 
 	state->BeginPerfEvent("Sharpening");
 
+	auto texturePool = TexturePool::GetSingleton();
+	auto copyTexture = texturePool->Acquire(upscalingTextureDesc);
+
 	context->CopyResource(inputTextureResource, outputTextureResource);
 
 	{
@@ -378,7 +451,7 @@ void Upscaling::SharpenTAA()
 			ID3D11ShaderResourceView* views[1] = { inputTextureSRV };
 			context->CSSetShaderResources(0, ARRAYSIZE(views), views);
 
-			ID3D11UnorderedAccessView* uavs[1] = { upscalingTexture->uav.get() };
+			ID3D11UnorderedAccessView* uavs[1] = { copyTexture->uav.get() };
 			context->CSSetUnorderedAccessViews(0, ARRAYSIZE(uavs), uavs, nullptr);
 
 			context->CSSetShader(GetRCASCS(), nullptr, 0);
@@ -398,7 +471,9 @@ void Upscaling::SharpenTAA()
 
 	state->EndPerfEvent();
 
-	context->CopyResource(outputTextureResource, upscalingTexture->resource.get());
+	context->CopyResource(outputTextureResource, copyTexture->resource.get());
+
+	texturePool->Release(copyTexture);
 
 	auto shadowState = RE::BSGraphics::RendererShadowState::GetSingleton();
 	GET_INSTANCE_MEMBER(stateUpdateFlags, shadowState)
@@ -420,14 +495,10 @@ void Upscaling::CreateUpscalingResources()
 	main.UAV->GetDesc(&uavDesc);
 
 	texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
+	texDesc.MiscFlags = 0;
 
-	texDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-	srvDesc.Format = texDesc.Format;
-	uavDesc.Format = texDesc.Format;
-
-	upscalingTexture = new Texture2D(texDesc);
-	upscalingTexture->CreateSRV(srvDesc);
-	upscalingTexture->CreateUAV(uavDesc);
+	upscalingTextureDesc = texDesc;
+	upscalingTextureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
 
 	texDesc.Format = DXGI_FORMAT_R8_UNORM;
 	srvDesc.Format = texDesc.Format;
@@ -440,10 +511,7 @@ void Upscaling::CreateUpscalingResources()
 
 void Upscaling::DestroyUpscalingResources()
 {
-	upscalingTexture->srv = nullptr;
-	upscalingTexture->uav = nullptr;
-	upscalingTexture->resource = nullptr;
-	delete upscalingTexture;
+	outputUAV = nullptr;
 
 	alphaMaskTexture->srv = nullptr;
 	alphaMaskTexture->uav = nullptr;
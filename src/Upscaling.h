@@ -71,9 +71,15 @@ public:
 	void Upscale();
 	void SharpenTAA();
 
-	Texture2D* upscalingTexture;
+	// Taken from the texture pool only while a copy or sharpening needs it, with direct input and output nothing is allocated
+	D3D11_TEXTURE2D_DESC upscalingTextureDesc{};
 	Texture2D* alphaMaskTexture;
 
+	// The game's TAA output is written directly when its format and bind flags allow it, the view keeps the resource alive
+	winrt::com_ptr<ID3D11UnorderedAccessView> outputUAV;
+	ID3D11UnorderedAccessView* GetOutputUAV(ID3D11Resource* a_output);
+	bool CanReadDirectly(ID3D11Resource* a_input);
+
 	void CreateUpscalingResources();
 	void DestroyUpscalingResources();
 
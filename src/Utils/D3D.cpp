@@ -218,4 +218,62 @@ namespace Util
 
 		return nullptr;
 	}
+
+	void GPUTimer::Begin(ID3D11DeviceContext* a_context)
+	{
+		auto& current = queries[index];
+
+		// The queries in this slot were issued Latency frames ago
+		if (current.pending)
+			Resolve(a_context, current);
+
+		if (!current.disjoint) {
+			auto device = State::GetSingleton()->device;
+
+			D3D11_QUERY_DESC desc{};
+			desc.Query = D3D11_QUERY_TIMESTAMP_DISJOINT;
+			DX::ThrowIfFailed(device->CreateQuery(&desc, current.disjoint.put()));
+			desc.Query = D3D11_QUERY_TIMESTAMP;
+			DX::ThrowIfFailed(device->CreateQuery(&desc, current.begin.put()));
+			DX::ThrowIfFailed(device->CreateQuery(&desc, current.end.put()));
+		}
+
+		a_context->Begin(current.disjoint.get());
+		a_context->End(current.begin.get());
+		active = true;
+	}
+
+	void GPUTimer::End(ID3D11DeviceContext* a_context)
+	{
+		if (!active)
+			return;
+
+		auto& current = queries[index];
+		a_context->End(current.end.get());
+		a_context->End(current.disjoint.get());
+		current.pending = true;
+
+		index = (index + 1) % Latency;
+		active = false;
+	}
+
+	void GPUTimer::Resolve(ID3D11DeviceContext* a_context, Queries& a_queries)
+	{
+		a_queries.pending = false;
+
+		// Never flush or spin here, a late result is simply dropped
+		D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjointData{};
+		if (a_context->GetData(a_queries.disjoint.get(), &disjointData, sizeof(disjointData), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK || disjointData.Disjoint)
+			return;
+
+		UINT64 beginTime = 0;
+		UINT64 endTime = 0;
+		if (a_context->GetData(a_queries.begin.get(), &beginTime, sizeof(beginTime), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK ||
+			a_context->GetData(a_queries.end.get(), &endTime, sizeof(endTime), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+			return;
+
+		float sample = (float)((double)(endTime - beginTime) / (double)disjointData.Frequency * 1000.0);
+		time = hasTime ? std::lerp(time, sample, 0.05f) : sample;
+		hasTime = true;
+	}
 }  // namespace Util
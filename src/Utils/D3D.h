@@ -1,5 +1,7 @@
 #pragma once
 
+#include <winrt/base.h>
+
 namespace Util
 {
 	ID3D11ShaderResourceView* GetSRVFromRTV(ID3D11RenderTargetView* a_rtv);
@@ -9,4 +11,43 @@ namespace Util
 	void SetResourceName(ID3D11DeviceChild* Resource, const char* Format, ...);
 
 	ID3D11DeviceChild* CompileShader(const wchar_t* FilePath, const std::vector<std::pair<const char*, const char*>>& Defines, const char* ProgramType, const char* Program = "main");
+
+	/**
+	 * Measures GPU time between Begin() and End() with timestamp queries.
+	 * Results are read back Latency frames later so the CPU never waits on the GPU.
+	 *
+	 * Usage:
+	 * timer.Begin(context);
+	 * ... draws/dispatches ...
+	 * timer.End(context);
+	 * ImGui::Text("%.3f ms", timer.GetTime());
+	*/
+	class GPUTimer
+	{
+	public:
+		static constexpr uint32_t Latency = 4;
+
+		void Begin(ID3D11DeviceContext* a_context);
+		void End(ID3D11DeviceContext* a_context);
+
+		// Smoothed GPU time in milliseconds
+		inline float GetTime() const { return time; }
+
+	private:
+		struct Queries
+		{
+			winrt::com_ptr<ID3D11Query> disjoint;
+			winrt::com_ptr<ID3D11Query> begin;
+			winrt::com_ptr<ID3D11Query> end;
+			bool pending = false;
+		};
+
+		void Resolve(ID3D11DeviceContext* a_context, Queries& a_queries);
+
+		Queries queries[Latency];
+		uint32_t index = 0;
+		bool active = false;
+		bool hasTime = false;
+		float time = 0.0f;
+	};
 }  // namespace Util
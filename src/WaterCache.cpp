@@ -0,0 +1,96 @@
+#include "WaterCache.h"
+
+#include "Util.h"
+
+void WaterCache::OnDataLoaded()
+{
+	if (auto scripts = RE::ScriptEventSourceHolder::GetSingleton()) {
+		scripts->AddEventSink<RE::TESCellAttachDetachEvent>(this);
+		logger::info("[WaterCache] Registered for TESCellAttachDetachEvent");
+	}
+}
+
+WaterCache::Tile WaterCache::LoadTile(RE::TES* a_tes, int a_cellX, int a_cellY)
+{
+	Tile tile;
+
+	// Interiors return their cell for any position
+	RE::NiPoint3 position{ ((float)a_cellX + 0.5f) * CELL_SIZE, ((float)a_cellY + 0.5f) * CELL_SIZE, 0.0f };
+	auto cell = a_tes->GetCell(position);
+	if (!cell)
+		return tile;
+
+	tile.valid = true;
+	tile.height = cell->GetExteriorWaterHeight();
+
+	RE::TESWaterForm* water = nullptr;
+	if (auto extraCellWaterType = cell->extraList.GetByType<RE::ExtraCellWaterType>())
+		water = extraCellWaterType->water;
+	if (!water) {
+		if (auto worldSpace = a_tes->GetRuntimeData2().worldSpace)
+			water = worldSpace->worldWater;
+	}
+
+	if (water) {
+		tile.color = { float(water->data.deepWaterColor.red) + float(water->data.shallowWaterColor.red),
+			float(water->data.deepWaterColor.green) + float(water->data.shallowWaterColor.green),
+			float(water->data.deepWaterColor.blue) + float(water->data.shallowWaterColor.blue) };
+		tile.color *= 0.5f / 255.0f;
+	}
+
+	return tile;
+}
+
+void WaterCache::GetWaterData(float4 (&a_data)[GRID_SIZE * GRID_SIZE])
+{
+	auto tes = RE::TES::GetSingleton();
+	if (!tes || !RE::BSGraphics::RendererShadowState::GetSingleton()) {
+		std::fill(std::begin(a_data), std::end(a_data), float4(1.0f, 1.0f, 1.0f, -FLT_MAX));
+		return;
+	}
+
+	auto position = Util::GetEyePosition(0);
+	int cellX = (int)std::floor(position.x / CELL_SIZE);
+	int cellY = (int)std::floor(position.y / CELL_SIZE);
+
+	int shiftX = cellX - originX;
+	int shiftY = cellY - originY;
+
+	if (dirty.exchange(false) || std::abs(shiftX) >= GRID_SIZE || std::abs(shiftY) >= GRID_SIZE) {
+		for (int k = -GRID_RADIUS; k <= GRID_RADIUS; k++)
+			for (int i = -GRID_RADIUS; i <= GRID_RADIUS; i++)
+				tiles[(i + GRID_RADIUS) + (k + GRID_RADIUS) * GRID_SIZE] = LoadTile(tes, cellX + i, cellY + k);
+	} else if (shiftX || shiftY) {
+		// Keep the tiles that are still inside the window and only look up the cells that entered it
+		Tile shifted[GRID_SIZE * GRID_SIZE];
+		for (int y = 0; y < GRID_SIZE; y++) {
+			for (int x = 0; x < GRID_SIZE; x++) {
+				int oldX = x + shiftX;
+				int oldY = y + shiftY;
+				if (oldX >= 0 && oldX < GRID_SIZE && oldY >= 0 && oldY < GRID_SIZE)
+					shifted[x + y * GRID_SIZE] = tiles[oldX + oldY * GRID_SIZE];
+				else
+					shifted[x + y * GRID_SIZE] = LoadTile(tes, cellX + x - GRID_RADIUS, cellY + y - GRID_RADIUS);
+			}
+		}
+		std::copy(std::begin(shifted), std::end(shifted), std::begin(tiles));
+	}
+
+	originX = cellX;
+	originY = cellY;
+
+	// The weather multiplier and camera height change every frame, both are cheap to apply
+	float3 multiplier = { 1.0f, 1.0f, 1.0f };
+	if (auto sky = RE::Sky::GetSingleton()) {
+		const auto& color = sky->skyColor[RE::TESWeather::ColorTypes::kWaterMultiplier];
+		multiplier = { color.red, color.green, color.blue };
+	}
+
+	for (int i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+		const auto& tile = tiles[i];
+		if (tile.valid)
+			a_data[i] = { tile.color.x * multiplier.x, tile.color.y * multiplier.y, tile.color.z * multiplier.z, tile.height - position.z };
+		else
+			a_data[i] = float4(1.0f, 1.0f, 1.0f, -FLT_MAX);
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+/**
+ * Water colour and height of the 5x5 cells around the camera, as used by SharedData.
+ * Cell water only changes when cells attach or detach, so tiles are looked up again on those events and
+ * when the camera crosses a cell boundary, instead of for every tile each frame.
+ */
+class WaterCache : public RE::BSTEventSink<RE::TESCellAttachDetachEvent>
+{
+public:
+	static WaterCache* GetSingleton()
+	{
+		static WaterCache singleton;
+		return &singleton;
+	}
+
+	static constexpr int GRID_RADIUS = 2;
+	static constexpr int GRID_SIZE = GRID_RADIUS * 2 + 1;
+	static constexpr float CELL_SIZE = 4096.0f;
+
+	void OnDataLoaded();
+
+	// xyz: water colour, w: water height relative to the camera, -FLT_MAX without a cell
+	void GetWaterData(float4 (&a_data)[GRID_SIZE * GRID_SIZE]);
+
+	virtual RE::BSEventNotifyControl ProcessEvent(const RE::TESCellAttachDetachEvent*, RE::BSTEventSource<RE::TESCellAttachDetachEvent>*) override
+	{
+		dirty = true;
+		return RE::BSEventNotifyControl::kContinue;
+	}
+
+private:
+	struct Tile
+	{
+		float3 color = { 1.0f, 1.0f, 1.0f };
+		float height = 0.0f;
+		bool valid = false;
+	};
+
+	Tile LoadTile(RE::TES* a_tes, int a_cellX, int a_cellY);
+
+	Tile tiles[GRID_SIZE * GRID_SIZE];
+	int originX = 0;  // cell containing the camera
+	int originY = 0;
+	std::atomic<bool> dirty = true;
+};
@@ -9,6 +9,7 @@
 #include "TruePBR.h"
 #include "Upscaling.h"
 #include "VariableCache.h"
+#include "WaterCache.h"
 
 #include "ENB/ENBSeriesAPI.h"
 
@@ -116,6 +117,7 @@ void MessageHandler(SKSE::MessagingInterface::Message* message)
 			if (errors.empty()) {
 				VariableCache::GetSingleton()->OnDataLoaded();
 				FrameAnnotations::OnDataLoaded();
+				WaterCache::GetSingleton()->OnDataLoaded();
 
 				auto& shaderCache = SIE::ShaderCache::Instance();
 				shaderCache.menuLoaded = true;